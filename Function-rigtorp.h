@@ -37,7 +37,7 @@ public:
 
   Function(const Function &other) {
     if (other) {
-      other.manager(data, other.data, Operation::Clone);
+      other.manager(&data, const_cast<Storage *>(&other.data), Operation::Clone);
       invoker = other.invoker;
       manager = other.manager;
     }
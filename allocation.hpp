@@ -0,0 +1,171 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#if !defined(BENCHMARK_ALLOCATION_HPP)
+#define BENCHMARK_ALLOCATION_HPP
+
+// Replaces the global operator new and delete to count the heap
+// allocations of the thread they're made on. Included by measure.hpp, so
+// by every benchmark program, in one translation unit only.
+
+#include <new>
+#include <cstddef>
+#include <cstdlib>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+namespace test
+{
+    struct allocation_stats
+    {
+        std::size_t count;  // calls to operator new
+        std::size_t bytes;  // requested
+    };
+
+    // Counted per thread, so that counting is cheap and the threads of
+    // the scaling mode don't share a cache line.
+    thread_local allocation_stats allocations = {0, 0};
+
+    // The allocations made on this thread since before was taken.
+    inline allocation_stats allocations_since(allocation_stats const& before)
+    {
+        allocation_stats const since =
+        {
+            allocations.count - before.count,
+            allocations.bytes - before.bytes
+        };
+        return since;
+    }
+
+    // What the allocations of a result are counted per, see --allocations.
+    const int number_of_allocation_points = 3;
+
+    inline char const* allocation_point_name(int i)
+    {
+        static char const* const names[number_of_allocation_points] =
+            {"construction", "copy", "call"};
+        return names[i];
+    }
+
+    namespace detail
+    {
+        inline void* allocate(std::size_t size)
+        {
+            ++allocations.count;
+            allocations.bytes += size;
+            return std::malloc(size ? size : 1);
+        }
+
+        inline void* allocate(std::size_t size, std::size_t alignment)
+        {
+            ++allocations.count;
+            allocations.bytes += size;
+#if defined(_MSC_VER)
+            return _aligned_malloc(size ? size : 1, alignment);
+#else
+            void* p = nullptr;
+            if (alignment < sizeof(void*))
+                alignment = sizeof(void*);
+            return posix_memalign(&p, alignment, size ? size : 1) == 0 ? p : nullptr;
+#endif
+        }
+
+        inline void deallocate_aligned(void* p)
+        {
+#if defined(_MSC_VER)
+            _aligned_free(p);
+#else
+            std::free(p);
+#endif
+        }
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    if (void* p = test::detail::allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, std::nothrow_t const&) noexcept
+{
+    return test::detail::allocate(size);
+}
+
+void* operator new[](std::size_t size, std::nothrow_t const&) noexcept
+{
+    return test::detail::allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::nothrow_t const&) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::nothrow_t const&) noexcept
+{
+    std::free(p);
+}
+
+#if defined(__cpp_aligned_new)
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void* p = test::detail::allocate(size, std::size_t(alignment)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    test::detail::deallocate_aligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+    test::detail::deallocate_aligned(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+    test::detail::deallocate_aligned(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+    test::detail::deallocate_aligned(p);
+}
+#endif
+
+#endif
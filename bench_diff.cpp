@@ -0,0 +1,204 @@
+// Compares two result files written with --json or --csv and flags the
+// (case, implementation) pairs whose per-call time got worse by more than a
+// threshold. Exits with 1 if there's any such regression.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include <cstring>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+struct entry
+{
+    double ns_per_call;
+    double ns_low;  // confidence interval, per call
+    double ns_high;
+};
+
+typedef std::map<std::pair<std::string, std::string>, entry> result_map;
+
+static entry make_entry(double calls, double ns_per_call, double ci_low, double ci_high)
+{
+    entry e = {ns_per_call, ns_per_call, ns_per_call};
+    if (calls > 0 && ci_high > 0)
+    {
+        e.ns_low = ci_low * 1e9 / calls;
+        e.ns_high = ci_high * 1e9 / calls;
+    }
+    return e;
+}
+
+static result_map read_json(std::istream& in)
+{
+    boost::property_tree::ptree tree;
+    boost::property_tree::read_json(in, tree);
+
+    result_map results;
+    for (auto const& item : tree.get_child("results"))
+    {
+        boost::property_tree::ptree const& r = item.second;
+        results[std::make_pair(r.get<std::string>("case"),
+            r.get<std::string>("implementation"))] =
+            make_entry(r.get<double>("calls"), r.get<double>("ns_per_call"),
+                r.get<double>("ci_low"), r.get<double>("ci_high"));
+    }
+    return results;
+}
+
+static std::vector<std::string> split_csv(std::string const& line)
+{
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (std::size_t i = 0; i != line.size(); ++i)
+    {
+        char const c = line[i];
+        if (quoted)
+        {
+            if (c != '"')
+                fields.back() += c;
+            else if (i + 1 != line.size() && line[i + 1] == '"')
+                fields.back() += line[++i];
+            else
+                quoted = false;
+        }
+        else if (c == '"')
+            quoted = true;
+        else if (c == ',')
+            fields.emplace_back();
+        else if (c != '\r')
+            fields.back() += c;
+    }
+    return fields;
+}
+
+static result_map read_csv(std::istream& in)
+{
+    std::string line;
+    std::getline(in, line);
+    std::vector<std::string> const header = split_csv(line);
+    std::map<std::string, std::size_t> column;
+    for (std::size_t i = 0; i != header.size(); ++i)
+        column[header[i]] = i;
+
+    char const* const required[] =
+        {"case", "implementation", "calls", "ns_per_call", "ci_low", "ci_high"};
+    for (char const* name : required)
+    {
+        if (!column.count(name))
+            throw std::runtime_error(std::string("missing column: ") + name);
+    }
+
+    result_map results;
+    while (std::getline(in, line))
+    {
+        if (line.empty())
+            continue;
+        std::vector<std::string> const f = split_csv(line);
+        if (f.size() != header.size())
+            throw std::runtime_error("malformed line: " + line);
+        results[std::make_pair(f[column["case"]], f[column["implementation"]])] =
+            make_entry(std::atof(f[column["calls"]].c_str()),
+                std::atof(f[column["ns_per_call"]].c_str()),
+                std::atof(f[column["ci_low"]].c_str()),
+                std::atof(f[column["ci_high"]].c_str()));
+    }
+    return results;
+}
+
+static result_map read_results(char const* path)
+{
+    std::ifstream in(path);
+    if (!in)
+        throw std::runtime_error(std::string("Couldn't open ") + path);
+
+    char c;
+    in >> c;
+    in.unget();
+    return c == '{' ? read_json(in) : read_csv(in);
+}
+
+int main(int argc, char* argv[])
+{
+    double threshold = 5;
+    bool bad_option = false;
+    std::vector<char const*> files;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strncmp(argv[i], "--threshold=", 12) == 0)
+            threshold = std::atof(argv[i] + 12);
+        else if (argv[i][0] == '-')
+            bad_option = true;
+        else
+            files.push_back(argv[i]);
+    }
+    if (bad_option || files.size() != 2)
+    {
+        std::cerr << "usage: " << argv[0] << " [--threshold=PERCENT] OLD NEW\n"
+            "  compares the ns/call of two result files (JSON or CSV), a\n"
+            "  slowdown above PERCENT (default 5) whose confidence intervals\n"
+            "  don't overlap is reported as a regression\n";
+        return 2;
+    }
+
+    result_map before, after;
+    try
+    {
+        before = read_results(files[0]);
+        after = read_results(files[1]);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << "\n";
+        return 2;
+    }
+
+    int regressions = 0;
+    std::cout.precision(3);
+    std::cout << std::fixed;
+    std::string current_case;
+    for (auto const& a : after)
+    {
+        if (a.first.first != current_case)
+        {
+            current_case = a.first.first;
+            std::cout << "[" << current_case << "]\n";
+        }
+        std::cout << a.first.second << ": ";
+
+        auto const b = before.find(a.first);
+        if (b == before.end())
+        {
+            std::cout << a.second.ns_per_call << " ns/call (new)\n";
+            continue;
+        }
+
+        entry const& old = b->second;
+        double const change = old.ns_per_call
+            ? (a.second.ns_per_call / old.ns_per_call - 1) * 100 : 0;
+        bool const significant =
+            a.second.ns_low > old.ns_high || a.second.ns_high < old.ns_low;
+        std::cout << old.ns_per_call << " -> " << a.second.ns_per_call
+            << " ns/call (" << std::showpos << change << std::noshowpos << "%)";
+        if (significant && change > threshold)
+        {
+            std::cout << " REGRESSION";
+            ++regressions;
+        }
+        else if (significant && change < -threshold)
+            std::cout << " improvement";
+        std::cout << "\n";
+    }
+    for (auto const& b : before)
+    {
+        if (!after.count(b.first))
+            std::cout << "[" << b.first.first << "] " << b.first.second
+                << ": missing from " << files[1] << "\n";
+    }
+
+    std::cout << regressions << " regression(s) above " << threshold << "%\n";
+    return regressions != 0;
+}
@@ -0,0 +1,69 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#if !defined(BENCHMARK_CLOCK_RATE_HPP)
+#define BENCHMARK_CLOCK_RATE_HPP
+
+#include "cycle_timer.hpp"
+#include <algorithm>
+
+namespace test
+{
+    namespace detail
+    {
+        // Run a chain of n dependent additions. Each one has to wait for
+        // the previous result, so the chain takes one core cycle per
+        // addition on every CPU we care about. The addend is kept in a
+        // register, recent cores fold chains of immediate additions.
+        inline unsigned long add_chain(unsigned long n)
+        {
+            unsigned long x = 0;
+            unsigned long one = 1;
+#if defined(__GNUC__)
+            __asm__ __volatile__("" : "+r"(one));
+#endif
+            for (unsigned long i = 0; i < n; i += 8)
+            {
+#if defined(__GNUC__)
+#define BENCHMARK_DEPENDENT_ADD x += one; __asm__ __volatile__("" : "+r"(x));
+                BENCHMARK_DEPENDENT_ADD BENCHMARK_DEPENDENT_ADD
+                BENCHMARK_DEPENDENT_ADD BENCHMARK_DEPENDENT_ADD
+                BENCHMARK_DEPENDENT_ADD BENCHMARK_DEPENDENT_ADD
+                BENCHMARK_DEPENDENT_ADD BENCHMARK_DEPENDENT_ADD
+#undef BENCHMARK_DEPENDENT_ADD
+#endif
+            }
+            return x;
+        }
+
+        inline double estimate_cycles_per_second()
+        {
+#if defined(__GNUC__)
+            unsigned long const n = 1ul << 26;
+            double best = 0;
+            // The first rounds also ramp the core up to its working clock.
+            for (int i = 0; i < 5; ++i)
+            {
+                util::cycle_timer time;
+                unsigned long const x = add_chain(n);
+                double const elapsed = time.elapsed();
+                if (x == n && elapsed > 0)
+                    best = (std::max)(best, n / elapsed);
+            }
+            return best;
+#else
+            // Without a way to stop the optimizer from folding the chain
+            // there's no estimate, cycles aren't reported.
+            return 0;
+#endif
+        }
+    }
+
+    // Estimated core clock in Hz, 0 if unknown. Computed on first use.
+    inline double cycles_per_second()
+    {
+        static double const rate = detail::estimate_cycles_per_second();
+        return rate;
+    }
+}
+
+#endif
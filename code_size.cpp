@@ -0,0 +1,194 @@
+// What the implementations cost at build time: the code_size_* targets
+// compile code_size_unit.cpp once per implementation and number of
+// lambdas with this program as the compiler launcher, which records the
+// compile wall time, the peak RSS of the compiler, and the size of the
+// executable sections and the number of symbols of the object file. The
+// code_size_report target then prints them under the names of the
+// implementations, and with --json or --csv writes them out as the
+// benchmark programs write their results.
+#include "result_sink.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <elf.h>
+
+namespace
+{
+    // Size of the sections holding code and the number of functions and
+    // objects defined in the ELF object file at path, false if it isn't
+    // one.
+    bool read_object(std::string const& path, double& text_bytes, double& symbols)
+    {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        std::vector<char> const file((std::istreambuf_iterator<char>(in)),
+            std::istreambuf_iterator<char>());
+        if (file.size() < sizeof(Elf64_Ehdr)
+            || std::memcmp(file.data(), ELFMAG, SELFMAG) != 0
+            || file[EI_CLASS] != ELFCLASS64)
+            return false;
+
+        Elf64_Ehdr const& header = *reinterpret_cast<Elf64_Ehdr const*>(file.data());
+        if (header.e_shoff + header.e_shnum * sizeof(Elf64_Shdr) > file.size())
+            return false;
+        Elf64_Shdr const* const sections =
+            reinterpret_cast<Elf64_Shdr const*>(file.data() + header.e_shoff);
+
+        text_bytes = symbols = 0;
+        for (int i = 0; i != header.e_shnum; ++i)
+        {
+            Elf64_Shdr const& s = sections[i];
+            if (s.sh_type == SHT_PROGBITS && (s.sh_flags & SHF_EXECINSTR))
+                text_bytes += double(s.sh_size);
+            else if (s.sh_type == SHT_SYMTAB
+                && s.sh_offset + s.sh_size <= file.size())
+            {
+                Elf64_Sym const* const syms =
+                    reinterpret_cast<Elf64_Sym const*>(file.data() + s.sh_offset);
+                for (std::size_t j = 0; j != s.sh_size / sizeof(Elf64_Sym); ++j)
+                {
+                    int const type = ELF64_ST_TYPE(syms[j].st_info);
+                    if (syms[j].st_shndx != SHN_UNDEF
+                        && (type == STT_FUNC || type == STT_OBJECT))
+                        ++symbols;
+                }
+            }
+        }
+        return true;
+    }
+
+    // --stats=FILE -- COMPILER ARGS...
+    //
+    // Runs the compiler and, if it succeeds, writes a line to FILE with what
+    // it measured. Exits with the status of the compiler.
+    //
+    // The names are left to report(): the build tools pass the arguments of
+    // a launcher to the shell as they are.
+    int launch(int argc, char* argv[])
+    {
+        std::string const stats = argv[1] + 8;
+        int i = 2;
+        if (i >= argc || std::strcmp(argv[i], "--") != 0 || ++i >= argc)
+        {
+            std::cerr << argv[0] << ": expected --stats=FILE -- COMPILER ARGS...\n";
+            return 2;
+        }
+
+        std::string object;
+        for (int j = i; j + 1 < argc; ++j)
+        {
+            if (std::strcmp(argv[j], "-o") == 0)
+                object = argv[j + 1];
+        }
+
+        std::chrono::steady_clock::time_point const start =
+            std::chrono::steady_clock::now();
+        pid_t const pid = fork();
+        if (pid == 0)
+        {
+            execvp(argv[i], argv + i);
+            std::cerr << argv[0] << ": couldn't run " << argv[i]
+                << ": " << std::strerror(errno) << "\n";
+            _exit(127);
+        }
+        if (pid < 0)
+        {
+            std::cerr << argv[0] << ": " << std::strerror(errno) << "\n";
+            return 2;
+        }
+        int status = 0;
+        struct rusage usage;
+        if (wait4(pid, &status, 0, &usage) != pid)
+            return 2;
+        double const seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+        if (!WIFEXITED(status))
+            return 2;
+        if (WEXITSTATUS(status) != 0)
+            return WEXITSTATUS(status);
+
+        double text_bytes = -1, symbols = -1;
+        if (!read_object(object, text_bytes, symbols))
+            std::cerr << argv[0] << ": couldn't read " << object << "\n";
+
+        std::ofstream out(stats.c_str());
+        out.precision(17);
+        out << seconds << ' ' << usage.ru_maxrss << ' '
+            << text_bytes << ' ' << symbols << '\n';
+        return out ? 0 : 2;
+    }
+
+    // [--json=FILE] [--csv=FILE] {[--case=NAME] --impl=NAME STATS}...
+    //
+    // Prints the lines written by launch() under the case and the
+    // implementation named before them, and passes them on to the sinks.
+    int report(int argc, char* argv[])
+    {
+        std::vector<test::result> results;
+        std::string case_name = "code_size", implementation;
+        for (int i = 1; i < argc; ++i)
+        {
+            if (std::strncmp(argv[i], "--json=", 7) == 0)
+                test::sinks.emplace_back(new test::json_sink(argv[i] + 7));
+            else if (std::strncmp(argv[i], "--csv=", 6) == 0)
+                test::sinks.emplace_back(new test::csv_sink(argv[i] + 6));
+            else if (std::strncmp(argv[i], "--case=", 7) == 0)
+                case_name = argv[i] + 7;
+            else if (std::strncmp(argv[i], "--impl=", 7) == 0)
+                implementation = argv[i] + 7;
+            else
+            {
+                test::result r;
+                std::ifstream in(argv[i]);
+                if (!(in >> r.compile_seconds >> r.compile_peak_rss
+                    >> r.text_bytes >> r.symbols))
+                {
+                    std::cerr << argv[0] << ": couldn't read " << argv[i] << "\n";
+                    return 2;
+                }
+                r.case_name = case_name;
+                r.implementation = implementation.empty() ? argv[i] : implementation;
+                r.name = "Size< " + r.implementation + " >";
+                results.push_back(r);
+            }
+        }
+
+        std::string current_case;
+        for (test::result const& r : results)
+        {
+            if (r.case_name != current_case)
+            {
+                current_case = r.case_name;
+                std::cout << "\n[" << current_case << "]\n";
+            }
+            std::cout << r.name << ": "
+                << std::fixed << std::setprecision(3)
+                << "{compile: " << r.compile_seconds << " s"
+                << ", peak RSS: " << r.compile_peak_rss / 1024 << " MB"
+                << std::setprecision(0)
+                << ", .text: " << r.text_bytes << " B"
+                << ", symbols: " << r.symbols << "}\n";
+            for (std::unique_ptr<test::sink> const& s : test::sinks)
+                s->write(r);
+        }
+        test::sinks.clear();
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && std::strncmp(argv[1], "--stats=", 8) == 0)
+        return launch(argc, argv);
+    return report(argc, argv);
+}
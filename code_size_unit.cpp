@@ -0,0 +1,129 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Compiled once per implementation and number of lambdas by the code_size_*
+// targets, see CMakeLists.txt and code_size.cpp: builds a wrapper from each
+// of CODE_SIZE_LAMBDAS distinct lambda types. Only the header of the
+// implementation under test is included, so that the compile time and the
+// object file are its own.
+
+#include <utility>
+#include <cstddef>
+
+#if !defined(CODE_SIZE_LAMBDAS)
+#define CODE_SIZE_LAMBDAS 10
+#endif
+
+#if defined(CODE_SIZE_NOEXCEPT)
+#define CODE_SIZE_SIGNATURE int(int) noexcept
+#else
+#define CODE_SIZE_SIGNATURE int(int)
+#endif
+
+#if defined(CODE_SIZE_NO_ABSTRACTION)
+#elif defined(CODE_SIZE_STDEX)
+#include "stdex.hpp"
+typedef stdex::function<CODE_SIZE_SIGNATURE> wrapper;
+#elif defined(CODE_SIZE_STD)
+#include <functional>
+typedef std::function<CODE_SIZE_SIGNATURE> wrapper;
+#elif defined(CODE_SIZE_CXX_FUNCTION)
+#include "cxx_function.hpp"
+typedef cxx_function::function<CODE_SIZE_SIGNATURE> wrapper;
+#elif defined(CODE_SIZE_MULTIFUNCTION)
+#include <boost/type_erasure/any.hpp>
+#include <boost/type_erasure/builtin.hpp>
+#include <boost/type_erasure/callable.hpp>
+// As in wrappers.hpp.
+typedef boost::type_erasure::any<
+    boost::mpl::vector<
+        boost::type_erasure::copy_constructible<>,
+        boost::type_erasure::typeid_<>,
+        boost::type_erasure::relaxed,
+        boost::type_erasure::callable<CODE_SIZE_SIGNATURE>
+    >
+> wrapper;
+#elif defined(CODE_SIZE_BOOST)
+#include <boost/function.hpp>
+typedef boost::function<CODE_SIZE_SIGNATURE> wrapper;
+#elif defined(CODE_SIZE_FUNC)
+#include "function.h"
+typedef func::function<CODE_SIZE_SIGNATURE> wrapper;
+#elif defined(CODE_SIZE_GENERIC_DELEGATE)
+#include "delegate.hpp"
+typedef generic::delegate<CODE_SIZE_SIGNATURE> wrapper;
+#elif defined(CODE_SIZE_FU2)
+#include "function2.hpp"
+typedef fu2::function<CODE_SIZE_SIGNATURE> wrapper;
+#elif defined(CODE_SIZE_FIXED_SIZE_FUNCTION)
+#include "fixed_size_function.hpp"
+typedef fixed_size_function<CODE_SIZE_SIGNATURE> wrapper;
+#elif defined(CODE_SIZE_EMBXX)
+#include "embxx/StaticFunction.h"
+typedef embxx::util::StaticFunction<CODE_SIZE_SIGNATURE, 48> wrapper;
+#elif defined(CODE_SIZE_RIGTORP)
+#include "Function-rigtorp.h"
+typedef Function<CODE_SIZE_SIGNATURE, 56> wrapper;
+#elif defined(CODE_SIZE_INPLACE_FUNCTION)
+#include "inplace_function.h"
+typedef stdext::inplace_function<CODE_SIZE_SIGNATURE, 40> wrapper;
+#elif defined(CODE_SIZE_DELEGATE)
+#define DELEGATE_ARGS_SIZE 40
+#define DELEGATE_ARGS_ALIGN 8
+#include <new>      // delegate.h doesn't include it
+#include "delegate.h"
+typedef delegate::Delegate<int, int> wrapper;
+#elif defined(CODE_SIZE_GNR)
+#include "forwarder.hpp"
+#if defined(CODE_SIZE_NOEXCEPT)
+typedef gnr::forwarder<int(int), 48, true> wrapper;
+#else
+typedef gnr::forwarder<int(int), 48> wrapper;
+#endif
+#elif defined(CODE_SIZE_FOLLY)
+#include "folly/Function.h"
+typedef folly::Function<CODE_SIZE_SIGNATURE> wrapper;
+#else
+#error "no implementation selected, see the code_size_* targets"
+#endif
+
+namespace code_size
+{
+    // A distinct closure type for every I.
+    template<std::size_t I>
+    auto lambda()
+    {
+        return [](int val)
+#if defined(CODE_SIZE_NOEXCEPT)
+            noexcept
+#endif
+        {
+            return val * int(I + 2);
+        };
+    }
+
+#if defined(CODE_SIZE_NO_ABSTRACTION)
+    template<std::size_t... I>
+    int call_all(int val, std::index_sequence<I...>)
+    {
+        return (lambda<I>()(val) + ...);
+    }
+#else
+    template<std::size_t... I>
+    int call_all(int val, std::index_sequence<I...>)
+    {
+        static wrapper table[] = {wrapper(lambda<I>())...};
+        int sum = 0;
+        for (wrapper& f : table)
+            sum += f(val);
+        return sum;
+    }
+#endif
+}
+
+// Keeps the instantiations from being dropped.
+int code_size_call_all(int val)
+{
+    return code_size::call_all(val,
+        std::make_index_sequence<CODE_SIZE_LAMBDAS>());
+}
@@ -0,0 +1,169 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#if !defined(BENCHMARK_COMMAND_LINE_HPP)
+#define BENCHMARK_COMMAND_LINE_HPP
+
+#include "measure.hpp"
+#include "result_sink.hpp"
+#include "registry.hpp"
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <regex>
+
+namespace test
+{
+    namespace detail
+    {
+        // Matches "--name=value", storing the value.
+        inline bool option(char const* arg, char const* name, std::string& value)
+        {
+            std::size_t const n = std::strlen(name);
+            if (std::strncmp(arg, name, n) != 0 || arg[n] != '=')
+                return false;
+            value = arg + n + 1;
+            return true;
+        }
+
+        inline bool valid_regex(char const* arg, std::string const& value)
+        {
+            try
+            {
+                std::regex check(value);
+                return true;
+            }
+            catch (std::regex_error const& e)
+            {
+                std::cerr << arg << ": " << e.what() << "\n";
+                return false;
+            }
+        }
+    }
+
+    inline void usage(char const* program)
+    {
+        std::cout << "usage: " << program << " [options]\n"
+            "  --case=REGEX      only run the cases matching REGEX\n"
+            "  --impl=REGEX      only run the implementations matching REGEX\n"
+            "  --list            list the selected cases and implementations\n"
+            "  --repeats=N       fixed repeats instead of calibrating them\n"
+            "  --time-budget=S   calibrate repeats so that a case takes S seconds"
+            " (default " << time_budget << ")\n"
+            "  --samples=N       timed runs per implementation (default "
+            << number_of_samples << ")\n"
+            "  --json=FILE       also write the results to FILE as JSON\n"
+            "  --csv=FILE        also write the results to FILE as CSV\n"
+            "  --accumulators=N  objects hammered in turn, the working set (default "
+            << default_accumulators << ")\n"
+            "  --shuffle         place the accumulators in memory in random order\n"
+            "  --sweep           run every case over working sets from 64 to 4M\n"
+            "                    accumulators, shuffled\n"
+            "  --threads[=N]     report the scaling over 1 to N pinned threads"
+            " (default " << hardware_threads() << ")\n"
+            "  --counters        read hardware counters (Linux perf events)\n"
+            "  --latency         also report the latency distribution per call\n"
+            "  --allocations     also report the heap allocations per construction,\n"
+            "                    copy and call\n";
+    }
+
+    // Applies the options common to all the benchmark executables. Returns
+    // false if the program should exit without running anything.
+    inline bool parse_command_line(int argc, char* argv[])
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string value;
+            if (detail::option(argv[i], "--case", value))
+            {
+                if (!detail::valid_regex(argv[i], value))
+                    return false;
+                case_filter = value;
+            }
+            else if (detail::option(argv[i], "--impl", value))
+            {
+                if (!detail::valid_regex(argv[i], value))
+                    return false;
+                impl_filter = value;
+            }
+            else if (std::strcmp(argv[i], "--list") == 0)
+                list_only = true;
+            else if (detail::option(argv[i], "--repeats", value))
+            {
+                fixed_repeats = std::atol(value.c_str());
+                if (fixed_repeats < 1)
+                {
+                    std::cerr << argv[i] << ": expected a positive number\n";
+                    return false;
+                }
+            }
+            else if (detail::option(argv[i], "--time-budget", value))
+            {
+                time_budget = std::atof(value.c_str());
+                if (time_budget <= 0)
+                {
+                    std::cerr << argv[i] << ": expected a positive number\n";
+                    return false;
+                }
+            }
+            else if (detail::option(argv[i], "--samples", value))
+            {
+                number_of_samples = std::atoi(value.c_str());
+                if (number_of_samples < 1)
+                {
+                    std::cerr << argv[i] << ": expected a positive number\n";
+                    return false;
+                }
+            }
+            else if (detail::option(argv[i], "--accumulators", value))
+            {
+                long const n = std::atol(value.c_str());
+                if (n < 1)
+                {
+                    std::cerr << argv[i] << ": expected a positive number\n";
+                    return false;
+                }
+                number_of_accumulators = std::size_t(n);
+            }
+            else if (std::strcmp(argv[i], "--shuffle") == 0)
+                shuffle_accumulators = true;
+            else if (std::strcmp(argv[i], "--sweep") == 0)
+            {
+                sweep_sizes = default_sweep();
+                shuffle_accumulators = true;
+            }
+            else if (std::strcmp(argv[i], "--threads") == 0)
+                max_threads = hardware_threads();
+            else if (detail::option(argv[i], "--threads", value))
+            {
+                int const n = std::atoi(value.c_str());
+                if (n < 1)
+                {
+                    std::cerr << argv[i] << ": expected a positive number\n";
+                    return false;
+                }
+                max_threads = unsigned(n);
+            }
+            else if (std::strcmp(argv[i], "--counters") == 0)
+                use_counters = true;
+            else if (std::strcmp(argv[i], "--latency") == 0)
+                use_latency = true;
+            else if (std::strcmp(argv[i], "--allocations") == 0)
+                use_allocations = true;
+            else if (detail::option(argv[i], "--json", value))
+                sinks.emplace_back(new json_sink(value));
+            else if (detail::option(argv[i], "--csv", value))
+                sinks.emplace_back(new csv_sink(value));
+            else
+            {
+                if (std::strcmp(argv[i], "--help") != 0)
+                    std::cerr << "unknown option: " << argv[i] << "\n";
+                usage(argv[0]);
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+#endif
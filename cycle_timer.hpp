@@ -0,0 +1,213 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#if !defined(CYCLE_TIMER_HPP)
+#define CYCLE_TIMER_HPP
+
+#include "high_resolution_timer.hpp"
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CYCLE_TIMER_HAS_TSC
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#include <cpuid.h>
+#endif
+#endif
+
+namespace util
+{
+    namespace detail
+    {
+#if defined(CYCLE_TIMER_HAS_TSC)
+        // The TSC only measures time if it ticks at a constant rate
+        // regardless of P-/C-states, which CPUID advertises as invariant.
+        inline bool invariant_tsc()
+        {
+#if defined(_MSC_VER)
+            int regs[4];
+            __cpuid(regs, 0x80000000);
+            if (unsigned(regs[0]) < 0x80000007u)
+                return false;
+            __cpuid(regs, 0x80000007);
+            return (regs[3] & (1 << 8)) != 0;
+#else
+            unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+            if (__get_cpuid_max(0x80000000u, nullptr) < 0x80000007u)
+                return false;
+            __get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx);
+            return (edx & (1u << 8)) != 0;
+#endif
+        }
+
+        // The fences keep the code being timed from being reordered
+        // around the reads: lfence; rdtsc; lfence to start, and rdtscp
+        // (which waits for the preceding instructions) then lfence to stop.
+        inline std::uint64_t tsc_begin()
+        {
+            _mm_lfence();
+            std::uint64_t const t = __rdtsc();
+            _mm_lfence();
+            return t;
+        }
+
+        inline std::uint64_t tsc_end()
+        {
+            unsigned aux;
+            std::uint64_t const t = __rdtscp(&aux);
+            _mm_lfence();
+            return t;
+        }
+#endif
+
+        // Nanoseconds from the steadiest clock the platform offers.
+        inline std::uint64_t monotonic_ns()
+        {
+#if defined(CLOCK_MONOTONIC_RAW)
+            timespec now;
+            if (-1 == clock_gettime(CLOCK_MONOTONIC_RAW, &now))
+                boost::throw_exception(std::runtime_error("Couldn't get current time"));
+            return std::uint64_t(now.tv_sec) * 1000000000u + now.tv_nsec;
+#elif defined(CLOCK_MONOTONIC)
+            timespec now;
+            if (-1 == clock_gettime(CLOCK_MONOTONIC, &now))
+                boost::throw_exception(std::runtime_error("Couldn't get current time"));
+            return std::uint64_t(now.tv_sec) * 1000000000u + now.tv_nsec;
+#elif defined(BOOST_WINDOWS)
+            LARGE_INTEGER now, frequency;
+            if (!QueryPerformanceCounter(&now) || !QueryPerformanceFrequency(&frequency))
+                boost::throw_exception(std::runtime_error("Couldn't get current time"));
+            return std::uint64_t(double(now.QuadPart) * 1e9 / double(frequency.QuadPart));
+#else
+            return std::uint64_t(high_resolution_timer::now() * 1e9);
+#endif
+        }
+
+        struct tick_source
+        {
+            tick_source()
+              : tsc(false), frequency(1e9)
+            {
+#if defined(CYCLE_TIMER_HAS_TSC)
+                if (!invariant_tsc())
+                    return;
+
+                // Calibrate against the monotonic clock, keeping the median
+                // of a few short rounds in case one gets preempted.
+                double rates[3];
+                for (double& rate : rates)
+                {
+                    std::uint64_t const t0 = monotonic_ns();
+                    std::uint64_t const c0 = tsc_begin();
+                    std::uint64_t t1;
+                    do
+                        t1 = monotonic_ns();
+                    while (t1 - t0 < 10000000u);    // 10ms
+                    std::uint64_t const c1 = tsc_end();
+                    rate = double(c1 - c0) * 1e9 / double(t1 - t0);
+                }
+                std::sort(rates, rates + 3);
+                if (rates[1] > 0)
+                {
+                    tsc = true;
+                    frequency = rates[1];
+                }
+#endif
+            }
+
+            bool tsc;
+            double frequency;   // ticks per second
+        };
+
+        inline tick_source const& ticks()
+        {
+            static tick_source const source;
+            return source;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //
+    //  cycle_timer
+    //      A timer object measures elapsed time, with the same interface as
+    //      high_resolution_timer. On x86-64 with an invariant TSC it counts
+    //      TSC ticks, calibrated against the monotonic clock on first use,
+    //      elsewhere it falls back to CLOCK_MONOTONIC_RAW nanoseconds.
+    //
+    ///////////////////////////////////////////////////////////////////////////
+    class cycle_timer
+    {
+    public:
+        cycle_timer()
+        {
+            restart();
+        }
+
+        // Raw reads, to time many short intervals without the conversion.
+        static std::uint64_t begin_ticks()
+        {
+#if defined(CYCLE_TIMER_HAS_TSC)
+            if (detail::ticks().tsc)
+                return detail::tsc_begin();
+#endif
+            return detail::monotonic_ns();
+        }
+
+        static std::uint64_t end_ticks()
+        {
+#if defined(CYCLE_TIMER_HAS_TSC)
+            if (detail::ticks().tsc)
+                return detail::tsc_end();
+#endif
+            return detail::monotonic_ns();
+        }
+
+        static double ticks_per_second()
+        {
+            return detail::ticks().frequency;
+        }
+
+        static char const* source()
+        {
+            return detail::ticks().tsc ? "tsc" : "monotonic clock";
+        }
+
+        static double now()
+        {
+            return double(begin_ticks()) / ticks_per_second();
+        }
+
+        void restart()
+        {
+            start_ticks = begin_ticks();
+        }
+
+        std::uint64_t elapsed_ticks() const
+        {
+            return end_ticks() - start_ticks;
+        }
+
+        double elapsed() const                  // return elapsed time in seconds
+        {
+            return double(elapsed_ticks()) / ticks_per_second();
+        }
+
+        double elapsed_max() const   // return estimated maximum value for elapsed()
+        {
+            return double((std::numeric_limits<std::uint64_t>::max)() - start_ticks)
+                / ticks_per_second();
+        }
+
+        double elapsed_min() const            // return minimum value for elapsed()
+        {
+            return 1.0 / ticks_per_second();
+        }
+
+    private:
+        std::uint64_t start_ticks;
+    };
+}
+
+#endif
@@ -0,0 +1,261 @@
+#include "wrappers.hpp"
+#include "command_line.hpp"
+#include <iomanip>
+#include <boost/type_erasure/is_empty.hpp>
+
+#define MAX_REPEAT 100000
+
+// What emptiness costs: calling an empty wrapper, testing a wrapper for
+// emptiness before calling it, and calling through a noexcept signature
+// rather than a throwing one where the wrapper takes it. The [empty]
+// table it starts with says what each wrapper does when called empty and
+// how it finds out.
+namespace emptiness
+{
+    // What calling an empty W does, and whether its call operator tests
+    // for it ("branch") or calls a stub installed in its place ("stub").
+    template<class W>
+    struct on_empty
+    {
+        static char const* call() { return "throws"; }
+        static char const* check() { return "branch"; }
+    };
+
+#define ON_EMPTY(W, what, how)                                                  \
+    template<>                                                                  \
+    struct on_empty<W>                                                          \
+    {                                                                           \
+        static char const* call() { return what; }                              \
+        static char const* check() { return how; }                              \
+    };                                                                          \
+    /***/
+
+    ON_EMPTY(stdex::function<int(int)>, "throws", "stub")
+    ON_EMPTY(cxx_function::function<int(int)>, "throws", "stub")
+    ON_EMPTY(multifunction<int(int)>, "throws", "stub")
+    ON_EMPTY(func::function<int(int)>, "throws", "stub")
+    ON_EMPTY(fu2::function<int(int)>, "throws", "stub")
+    ON_EMPTY(inplace_function, "throws", "stub")
+    ON_EMPTY(Delegate, "returns R()", "stub")
+    ON_EMPTY(generic_delegate, "undefined", "-")
+    ON_EMPTY(embxx_util_StaticFunction, "undefined", "assert")
+    OPT_GNR(ON_EMPTY(gnr_forwarder, "undefined", "-"))
+    OPT_FOLLY(ON_EMPTY(folly::Function<int(int)>, "throws", "stub"))
+
+#undef ON_EMPTY
+
+    // The wrappers whose empty call is undefined are left out of
+    // empty_call.
+    template<class W>
+    struct defined_when_empty
+      : std::true_type
+    {};
+
+    template<>
+    struct defined_when_empty<generic_delegate>
+      : std::false_type
+    {};
+
+    template<>
+    struct defined_when_empty<embxx_util_StaticFunction>
+      : std::false_type
+    {};
+
+#ifdef ADD_GNR
+    template<>
+    struct defined_when_empty<gnr_forwarder>
+      : std::false_type
+    {};
+#endif
+
+    // The throw alone, without a wrapper.
+    int throw_bad_call(int)
+    {
+        throw std::bad_function_call();
+    }
+
+    // Calls a default constructed wrapper, catching what it throws.
+    template<class F>
+    struct empty_call : cases::base<F>
+    {
+        void benchmark()
+        {
+            try
+            {
+                this->val += this->f(this->val);
+            }
+            catch (std::exception const&)
+            {
+                this->val += 1;
+            }
+        }
+    };
+
+    template<>
+    struct empty_call<no_abstraction> : empty_call<int(*)(int)>
+    {
+        empty_call()
+        {
+            this->f = &throw_bad_call;
+        }
+    };
+
+    // Whether f is set, for the wrappers without an operator bool.
+    template<class F>
+    bool is_set(F const& f)
+    {
+        return bool(f);
+    }
+
+    template<class Concept, class T>
+    bool is_set(boost::type_erasure::any<Concept, T> const& f)
+    {
+        return !boost::type_erasure::is_empty(f);
+    }
+
+    // Delegate can't be tested, it's never empty but for its stub.
+    template<class W>
+    struct testable
+      : std::true_type
+    {};
+
+    template<>
+    struct testable<Delegate>
+      : std::false_type
+    {};
+
+    // Tests the wrapper before calling it, as the callers that can't tell
+    // whether it's set do.
+    template<class F>
+    struct checked_call : cases::base<F>
+    {
+        checked_call()
+          : cases::base<F>(&plain)
+        {}
+
+        void benchmark()
+        {
+            if (is_set(this->f))
+                this->val += this->f(this->val);
+        }
+    };
+
+    template<>
+    struct checked_call<no_abstraction> : checked_call<int(*)(int)>
+    {};
+
+    // Holds a value to write back when it's destroyed, so that the call
+    // it's around needs unwinding if it can throw.
+    struct guard
+    {
+        ~guard()
+        {
+            *val ^= 1;
+        }
+
+        int* val;
+    };
+
+    int noexcept_plain(int val) noexcept
+    {
+        return val * 2;
+    }
+
+    // The wrappers that take a noexcept signature, under int(int) and
+    // int(int) noexcept. The callable is noexcept in both.
+    template<class F>
+    struct signature_call : cases::base<F>
+    {
+        signature_call()
+          : cases::base<F>(&noexcept_plain)
+        {}
+
+        void benchmark()
+        {
+            guard g = {&this->val};
+            this->val += this->f(this->val);
+        }
+    };
+
+    template<>
+    struct signature_call<no_abstraction> : signature_call<int(*)(int) noexcept>
+    {};
+
+    template<class F>
+    using throwing_signature = signature_call<F>;
+
+    template<class F>
+    using noexcept_signature = signature_call<F>;
+
+    typedef test::concat<wrappers::common, wrappers::optional>::type all;
+
+    typedef test::concat<
+        wrappers::baseline,
+        test::filter<defined_when_empty, all>::type
+    >::type defined;
+
+    typedef test::filter<testable, all>::type tested;
+
+    typedef test::concat<
+        wrappers::baseline,
+        test::type_list<
+            fu2::function<int(int)>,
+            cxx_function::function<int(int)>
+        >,
+        test::type_list<OPT_GNR(gnr_forwarder)>,
+        test::type_list<OPT_FOLLY(folly::Function<int(int)>)>
+    >::type throwing_wrappers;
+
+    typedef test::concat<
+        wrappers::baseline,
+        test::type_list<
+            fu2::function<int(int) noexcept>,
+            cxx_function::function<int(int) noexcept>
+        >,
+        test::type_list<OPT_GNR(gnr::forwarder<int(int), 48, true>)>,
+        test::type_list<OPT_FOLLY(folly::Function<int(int) noexcept>)>
+    >::type noexcept_wrappers;
+
+    template<class... W>
+    void show_empty(test::type_list<W...>)
+    {
+        std::vector<std::string> const names = {test::wrapper_name<W>::get()...};
+        std::vector<char const*> const calls = {on_empty<W>::call()...};
+        std::vector<char const*> const checks = {on_empty<W>::check()...};
+        std::size_t width = 0;
+        for (std::string const& name : names)
+            width = (std::max)(width, name.size());
+
+        for (std::size_t i = 0; i != names.size(); ++i)
+        {
+            std::cout << names[i] << std::string(width - names[i].size(), ' ')
+                << ' ' << std::setw(12) << calls[i]
+                << ' ' << std::setw(7) << checks[i] << "\n";
+        }
+    }
+}
+
+OPT_GNR(BENCHMARK_NAMED_WRAPPER("gnr_forwarder", gnr::forwarder<int(int), 48, true>))
+
+BENCHMARK_REGISTER(empty_call, emptiness::empty_call, emptiness::defined)
+BENCHMARK_REGISTER(call, cases::function_pointer, wrappers::baseline, emptiness::all)
+BENCHMARK_REGISTER(checked_call, emptiness::checked_call, wrappers::baseline, emptiness::tested)
+BENCHMARK_REGISTER(throwing_signature, emptiness::throwing_signature, emptiness::throwing_wrappers)
+BENCHMARK_REGISTER(noexcept_signature, emptiness::noexcept_signature, emptiness::noexcept_wrappers)
+
+int main(int argc, char* argv[])
+{
+    if (!test::parse_command_line(argc, argv))
+        return 2;
+
+    if (!test::list_only)
+    {
+        std::cout << "[empty]\n";
+        emptiness::show_empty(emptiness::all());
+        std::cout << "\n";
+    }
+
+    test::run_benchmarks(MAX_REPEAT);
+
+    return test::live_code != 0;
+}
@@ -0,0 +1,141 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#if !defined(BENCHMARK_HISTOGRAM_HPP)
+#define BENCHMARK_HISTOGRAM_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace test
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //
+    //  histogram
+    //      Log-linear histogram in the spirit of HdrHistogram: values below
+    //      sub_buckets are counted exactly, above that every power of two is
+    //      split into sub_buckets / 2 linear buckets, so any value is known
+    //      within 1 / sub_buckets of itself (about 3%) whatever its
+    //      magnitude. The maximum is tracked exactly.
+    //
+    ///////////////////////////////////////////////////////////////////////////
+    class histogram
+    {
+    public:
+        static const unsigned sub_bucket_bits = 6;
+        static const std::uint64_t sub_buckets = 1u << sub_bucket_bits;
+
+        histogram()
+          : total(0), largest(0)
+        {}
+
+        void record(std::uint64_t value)
+        {
+            std::size_t const i = index_of(value);
+            if (i >= counts.size())
+                counts.resize(i + 1);
+            ++counts[i];
+            ++total;
+            if (value > largest)
+                largest = value;
+        }
+
+        void clear()
+        {
+            counts.clear();
+            total = 0;
+            largest = 0;
+        }
+
+        std::uint64_t count() const
+        {
+            return total;
+        }
+
+        std::uint64_t max() const
+        {
+            return largest;
+        }
+
+        // The value below which the given percentage of the recorded values
+        // fall, reported as the middle of its bucket.
+        double percentile(double p) const
+        {
+            if (!total)
+                return 0;
+
+            std::uint64_t const rank = std::uint64_t(p / 100 * (total - 1)) + 1;
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i != counts.size(); ++i)
+            {
+                seen += counts[i];
+                if (seen >= rank)
+                {
+                    double const mid = (double(lowest_of(i)) + double(highest_of(i))) / 2;
+                    return mid < double(largest) ? mid : double(largest);
+                }
+            }
+            return double(largest);
+        }
+
+    private:
+        static unsigned msb(std::uint64_t v)
+        {
+            unsigned n = 0;
+            while (v >>= 1)
+                ++n;
+            return n;
+        }
+
+        static std::size_t index_of(std::uint64_t v)
+        {
+            if (v < sub_buckets)
+                return std::size_t(v);
+
+            unsigned const shift = msb(v) - sub_bucket_bits + 1;
+            std::uint64_t const sub = v >> shift;   // in [sub_buckets / 2, sub_buckets)
+            return std::size_t(sub_buckets + (shift - 1) * (sub_buckets / 2)
+                + (sub - sub_buckets / 2));
+        }
+
+        static std::uint64_t lowest_of(std::size_t i)
+        {
+            if (i < sub_buckets)
+                return i;
+
+            std::size_t const j = i - sub_buckets;
+            unsigned const shift = unsigned(j / (sub_buckets / 2)) + 1;
+            std::uint64_t const sub = j % (sub_buckets / 2) + sub_buckets / 2;
+            return sub << shift;
+        }
+
+        static std::uint64_t highest_of(std::size_t i)
+        {
+            if (i < sub_buckets)
+                return i;
+            return lowest_of(i + 1) - 1;
+        }
+
+        std::vector<std::uint64_t> counts;
+        std::uint64_t total;
+        std::uint64_t largest;
+    };
+
+    // The points of the latency distribution that are reported.
+    const int number_of_percentiles = 5;
+
+    inline double percentile_point(int i)
+    {
+        static double const points[number_of_percentiles] = {50, 90, 99, 99.9, 100};
+        return points[i];
+    }
+
+    inline char const* percentile_name(int i)
+    {
+        static char const* const names[number_of_percentiles] =
+            {"p50", "p90", "p99", "p99.9", "max"};
+        return names[i];
+    }
+}
+
+#endif
@@ -0,0 +1,331 @@
+#include "wrappers.hpp"
+#include "allocation.hpp"
+#include "command_line.hpp"
+
+#define MAX_REPEAT 100000
+
+// The lifecycle of the wrappers, built from every kind of callable of
+// various.cpp: where various.cpp builds them once and times the calls,
+// these time what the callbacks created per request, and moved through
+// queues and containers, cost besides.
+namespace lifecycle
+{
+    // Builds the accumulator of a case, and with it the wrapper from its
+    // callable, then destroys it again. The rest of the accumulator is
+    // a couple of ints.
+    template<template<class> class Case, class F>
+    struct construct : test::base
+    {
+        typedef typename Case<F>::function_type function_type;
+
+        void benchmark()
+        {
+            Case<F> c;
+            test::escape(c.f);
+            this->val += c.val + 1;
+        }
+    };
+
+    // The accumulator of a case, holding a wrapper f and a second one g
+    // built the same way, to copy and move them between each other. The
+    // copies are made from const references, which the wrappers with a
+    // forwarding constructor would otherwise take for a callable.
+    template<template<class> class Case, class F>
+    struct pair_base : test::base
+    {
+        typedef typename Case<F>::function_type function_type;
+
+        pair_base()
+          : g(source())
+        {}
+
+        function_type const& source() const
+        {
+            return c.f;
+        }
+
+        Case<F> c;
+        function_type g;
+    };
+
+    template<template<class> class Case, class F>
+    struct copy_construct : pair_base<Case, F>
+    {
+        void benchmark()
+        {
+            typename pair_base<Case, F>::function_type copy(this->source());
+            test::escape(copy);
+            this->val += this->c.val + 1;
+        }
+    };
+
+    // Moves the wrapper back and forth between f and a spare slot,
+    // destroying the source of each move: the cost of leaving it empty
+    // and getting rid of it is counted along with the move.
+    template<template<class> class Case, class F>
+    struct move_construct : pair_base<Case, F>
+    {
+        typedef typename pair_base<Case, F>::function_type function_type;
+
+        move_construct()
+          : from(&this->c.f), to(reinterpret_cast<function_type*>(&spare))
+        {}
+
+        ~move_construct()
+        {
+            if (from != &this->c.f)
+                benchmark();
+        }
+
+        void benchmark()
+        {
+            ::new (static_cast<void*>(to)) function_type(std::move(*from));
+            from->~function_type();
+            std::swap(from, to);
+            test::escape(*from);
+            this->val += this->c.val + 1;
+        }
+
+        function_type* from;
+        function_type* to;
+        typename std::aligned_storage<sizeof(function_type),
+            alignof(function_type)>::type spare;
+    };
+
+    template<template<class> class Case, class F>
+    struct copy_assign : pair_base<Case, F>
+    {
+        void benchmark()
+        {
+            this->g = this->source();
+            test::escape(this->g);
+            this->val += this->c.val + 1;
+        }
+    };
+
+    // Moves f to g and back, each move assigning over a wrapper that
+    // was left empty by the previous one.
+    template<template<class> class Case, class F>
+    struct move_assign : pair_base<Case, F>
+    {
+        static const int calls_per_benchmark = 2;
+
+        void benchmark()
+        {
+            this->g = std::move(this->c.f);
+            test::escape(this->g);
+            this->c.f = std::move(this->g);
+            test::escape(this->c.f);
+            this->val += this->c.val + 1;
+        }
+    };
+
+    template<template<class> class Case, class F>
+    struct swap : pair_base<Case, F>
+    {
+        void benchmark()
+        {
+            using std::swap;
+            swap(this->c.f, this->g);
+            test::escape(this->g);
+            this->val += this->c.val + 1;
+        }
+    };
+
+    // Rebinds one wrapper slot in turn to callables of different kinds
+    // and sizes, as a per-connection handler reassigned on every event
+    // would be: a function pointer, a lambda capturing an int, a functor
+    // holding a reference and a heavy functor of ten ints. Each call is
+    // one assignment, the wrapper is invoked once per round.
+    template<class F>
+    struct rebind : test::base
+    {
+        typedef F function_type;
+
+        static const int calls_per_benchmark = 4;
+
+        rebind()
+          : f(func1())
+        {}
+
+        void assign_all()
+        {
+            int const b = a;
+            f = &plain;
+            test::escape(f);
+            f = [b](int val)
+            {
+                return val * b;
+            };
+            test::escape(f);
+            f = func2{a};
+            test::escape(f);
+            f = func1();
+            test::escape(f);
+        }
+
+        void benchmark()
+        {
+            assign_all();
+            this->val += f(this->val);
+        }
+
+        F f;
+        int a = 2;
+    };
+
+    // Heap allocations and bytes per assignment of rebind<F> once it has
+    // gone through a round: the wrappers recycling their storage make
+    // fewer than those building every callable anew.
+    template<class F>
+    test::allocation_stats rebind_allocations()
+    {
+        rebind<F> r;
+        r.assign_all();
+        test::allocation_stats const before = test::allocations;
+        r.assign_all();
+        return {
+            test::allocations.count - before.count,
+            test::allocations.bytes - before.bytes
+        };
+    }
+
+    template<class... F>
+    void show_rebind(test::type_list<F...>)
+    {
+        char const* const names[] = {"", test::wrapper_name<F>::get()...};
+        test::allocation_stats const stats[] = {{0, 0}, rebind_allocations<F>()...};
+        int const calls[] = {1, rebind<F>::calls_per_benchmark...};
+        std::cout.precision(2);
+        std::cout << std::fixed;
+        for (std::size_t i = 1; i != sizeof...(F) + 1; ++i)
+        {
+            std::cout << "  " << names[i] << ": "
+                << double(stats[i].count) / calls[i] << " allocations, "
+                << double(stats[i].bytes) / calls[i] << " bytes per assignment\n";
+        }
+    }
+
+    // Heap allocations made to build the wrapper of Case<F>, 0 if the
+    // callable is stored inline.
+    template<template<class> class Case, class F>
+    std::size_t construction_allocations()
+    {
+        std::size_t const before = test::allocations.count;
+        {
+            Case<F> c;
+            test::escape(c.f);
+        }
+        return test::allocations.count - before;
+    }
+
+    template<template<class> class Case, class... F>
+    void show_storage(char const* kind, test::type_list<F...>)
+    {
+        char const* const names[] = {"", test::wrapper_name<F>::get()...};
+        std::size_t const allocations[] = {0, construction_allocations<Case, F>()...};
+        std::cout << kind << "\n";
+        for (int heap = 0; heap != 2; ++heap)
+        {
+            std::cout << (heap ? "  heap:  " : "  inline:");
+            char const* sep = " ";
+            for (std::size_t i = 1; i != sizeof...(F) + 1; ++i)
+            {
+                if ((allocations[i] != 0) == (heap != 0))
+                {
+                    std::cout << sep << names[i];
+                    sep = ", ";
+                }
+            }
+            std::cout << "\n";
+        }
+    }
+
+    // Which path the construction of each kind takes, per wrapper.
+    inline std::vector<void (*)()>& storage_tables()
+    {
+        static std::vector<void (*)()> tables;
+        return tables;
+    }
+}
+
+#define LIFECYCLE_OPERATION(operation, kind, ...)                               \
+    namespace lifecycle                                                         \
+    {                                                                           \
+        template<class F>                                                       \
+        using operation##_##kind = operation<cases::kind, F>;                   \
+    }                                                                           \
+    BENCHMARK_REGISTER(operation##_##kind, lifecycle::operation##_##kind, __VA_ARGS__) \
+    /***/
+
+#define LIFECYCLE(kind, ...)                                                    \
+    LIFECYCLE_OPERATION(construct, kind, __VA_ARGS__)                           \
+    LIFECYCLE_OPERATION(copy_construct, kind, __VA_ARGS__)                      \
+    LIFECYCLE_OPERATION(move_construct, kind, __VA_ARGS__)                      \
+    LIFECYCLE_OPERATION(copy_assign, kind, __VA_ARGS__)                         \
+    LIFECYCLE_OPERATION(move_assign, kind, __VA_ARGS__)                         \
+    LIFECYCLE_OPERATION(swap, kind, __VA_ARGS__)                                \
+    namespace lifecycle                                                         \
+    {                                                                           \
+        inline void storage_##kind()                                            \
+        {                                                                       \
+            show_storage<cases::kind>(#kind, test::concat<__VA_ARGS__>::type()); \
+        }                                                                       \
+    }                                                                           \
+    static bool const storage_registered_##kind =                               \
+        (lifecycle::storage_tables().push_back(&lifecycle::storage_##kind), true); \
+    /***/
+
+LIFECYCLE(function_pointer,
+    wrappers::baseline, wrappers::common,
+    wrappers::fast_delegate, wrappers::fast_func, wrappers::optional)
+
+LIFECYCLE(compile_time_function_pointer,
+    wrappers::baseline, wrappers::common, wrappers::optional)
+
+LIFECYCLE(compile_time_delegate,
+    wrappers::baseline, wrappers::common, wrappers::optional)
+
+LIFECYCLE(heavy_functor,
+    wrappers::common, wrappers::optional,
+    wrappers::stdex_capacities)
+
+LIFECYCLE(non_assignable,
+    wrappers::common, wrappers::optional,
+    wrappers::stdex_capacities)
+
+LIFECYCLE(lambda_capture,
+    wrappers::common, wrappers::fast_func, wrappers::optional,
+    wrappers::stdex_capacities)
+
+LIFECYCLE(stateless_lambda,
+    wrappers::common, wrappers::fast_delegate, wrappers::fast_func, wrappers::optional)
+
+#undef LIFECYCLE
+#undef LIFECYCLE_OPERATION
+
+typedef test::concat<wrappers::common, wrappers::optional>::type rebind_wrappers;
+
+BENCHMARK_REGISTER(rebind, lifecycle::rebind, rebind_wrappers)
+
+int main(int argc, char* argv[])
+{
+    if (!test::parse_command_line(argc, argv))
+        return 2;
+
+    if (!test::list_only)
+    {
+        std::cout << "[storage]\n";
+        for (void (*table)() : lifecycle::storage_tables())
+            table();
+        std::cout << "\n";
+
+        std::cout << "[rebind allocations]\n";
+        lifecycle::show_rebind(rebind_wrappers());
+        std::cout << "\n";
+    }
+
+    test::run_benchmarks(MAX_REPEAT);
+
+    return test::live_code != 0;
+}
@@ -13,11 +13,22 @@
 # define _SECURE_SCL 0 
 #endif
 
-#include "high_resolution_timer.hpp"
+#include "cycle_timer.hpp"
+#include "statistics.hpp"
+#include "result_sink.hpp"
+#include "clock_rate.hpp"
+#include "perf_counters.hpp"
+#include "histogram.hpp"
+#include "allocation.hpp"
 #include <iostream>
 #include <cstring>
-#include <boost/preprocessor/seq/for_each.hpp>
-#include <boost/preprocessor/stringize.hpp>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <memory>
+#include <random>
+#include <new>
 
 namespace test
 {
@@ -27,9 +38,143 @@ namespace test
     // sure it's needed.
     int live_code;
 
-    // Call objects of the given Accumulator type repeatedly
+    // Makes the compiler assume x is read and written by something it
+    // can't see, for objects whose construction is what is measured and
+    // that would be dead code otherwise.
+    template <class T>
+    inline void escape(T const& x)
+    {
+#if defined(__GNUC__)
+        asm volatile("" : : "r"(&x) : "memory");
+#else
+        static void const* volatile sink;
+        sink = &x;
+#endif
+    }
+
+    // Number of timed runs per (case, implementation) pair.
+    int number_of_samples = 10;
+
+    // Minimum time [s] one run over all the implementations of a benchmark
+    // should take, repeats are raised until it does.
+    double time_budget = 0.2;
+
+    // This has to be at least as large as the number of
+    // simultaneous accumulations that can be executing in the
+    // compiler pipeline.  A safe number here is larger than the
+    // machine's maximum pipeline depth. If you want to test the L2
+    // or L3 cache, or main memory, you can increase the size of
+    // this array (--accumulators, --sweep).  1024 is an upper limit
+    // on the pipeline depth of current vector machines.
+    const std::size_t default_accumulators = 1024;
+    std::size_t number_of_accumulators = default_accumulators;
+
+    // Places the accumulators in memory in a random order, so that
+    // walking them defeats the hardware prefetchers, set by --shuffle.
+    bool shuffle_accumulators = false;
+
+    // Enables the latency mode, set by --latency.
+    bool use_latency = false;
+
+    // Number of calls timed together in the latency mode, the smallest
+    // interval the timer can measure with reasonable overhead.
+    int latency_batch = 8;
+
+    // Enables the allocation accounting, set by --allocations.
+    bool use_allocations = false;
+
+    // Number of invocations made by one call to benchmark(), accumulators
+    // that make more than one should override it.
     template <class Accumulator>
-    void hammer(long const repeats)
+    struct calls_per_benchmark
+      : std::integral_constant<int, Accumulator::calls_per_benchmark>
+    {};
+
+    // Size of the function object under test, accumulators name its
+    // type function_type.
+    template <class Accumulator, class = void>
+    struct function_size
+      : std::integral_constant<std::size_t, sizeof(Accumulator)>
+    {};
+
+    template <class Accumulator>
+    struct function_size<Accumulator,
+        typename std::enable_if<sizeof(typename Accumulator::function_type) != 0>::type>
+      : std::integral_constant<std::size_t,
+            sizeof(typename Accumulator::function_type)>
+    {};
+
+    // Results of the benchmark currently being run, see rank().
+    std::vector<result> results;
+
+    ///////////////////////////////////////////////////////////////////////////
+    //
+    //  accumulator_array
+    //      number_of_accumulators accumulators on the heap. Shuffled, they
+    //      are still constructed and visited in order, but each one sits at
+    //      a random slot of the storage, reached through a table of
+    //      pointers.
+    //
+    ///////////////////////////////////////////////////////////////////////////
+    template <class Accumulator>
+    class accumulator_array
+    {
+    public:
+        accumulator_array(std::size_t n, bool shuffled)
+          : n(n), storage(std::allocator<Accumulator>().allocate(n))
+        {
+            std::vector<std::size_t> slots(n);
+            for (std::size_t i = 0; i != n; ++i)
+                slots[i] = i;
+            if (shuffled)
+            {
+                std::mt19937 gen(5489u);
+                std::shuffle(slots.begin(), slots.end(), gen);
+                visit.reserve(n);
+            }
+            for (std::size_t i = 0; i != n; ++i)
+            {
+                Accumulator* const p = ::new (storage + slots[i]) Accumulator;
+                if (shuffled)
+                    visit.push_back(p);
+            }
+        }
+
+        ~accumulator_array()
+        {
+            for (Accumulator* ap = storage; ap != storage + n; ++ap)
+                ap->~Accumulator();
+            std::allocator<Accumulator>().deallocate(storage, n);
+        }
+
+        bool shuffled() const { return !visit.empty(); }
+
+        Accumulator* begin() const { return storage; }
+        Accumulator* end() const { return storage + n; }
+
+        // The i-th accumulator in visiting order.
+        Accumulator* operator[](std::size_t i) const
+        {
+            return visit.empty() ? storage + i : visit[i];
+        }
+
+        Accumulator* const* visit_begin() const { return visit.data(); }
+        Accumulator* const* visit_end() const { return visit.data() + visit.size(); }
+
+    private:
+        accumulator_array(accumulator_array const&);
+        accumulator_array& operator=(accumulator_array const&);
+
+        std::size_t n;
+        Accumulator* storage;
+        std::vector<Accumulator*> visit;
+    };
+
+    // Call objects of the given Accumulator type repeatedly, and return
+    // the sum of their values. Touches nothing but the accumulators, so
+    // threads can each hammer their own array.
+    template <class Accumulator>
+    int hammer(accumulator_array<Accumulator> const& a, long const repeats)
     {
         // Strategy: because the sum in an accumulator after each call
         // depends on the previous value of the sum, the CPU's pipeline
@@ -45,38 +190,63 @@ namespace test
         // concern is specific to the particular application at which
         // we're targeting the test. ***
 
-        // This has to be at least as large as the number of
-        // simultaneous accumulations that can be executing in the
-        // compiler pipeline.  A safe number here is larger than the
-        // machine's maximum pipeline depth. If you want to test the L2
-        // or L3 cache, or main memory, you can increase the size of
-        // this array.  1024 is an upper limit on the pipeline depth of
-        // current vector machines.
-        
-        const std::size_t number_of_accumulators = 1024;
-        live_code = 0; // reset to zero
-
-        Accumulator a[number_of_accumulators];
-        
-        for (long iteration = 0; iteration < repeats; ++iteration)
-        {
-            for (Accumulator* ap = a;  ap < a + number_of_accumulators; ++ap)
+        if (a.shuffled())
+        {
+            for (long iteration = 0; iteration < repeats; ++iteration)
             {
-                ap->benchmark();
+                for (Accumulator* const* pp = a.visit_begin(); pp < a.visit_end(); ++pp)
+                {
+                    (*pp)->benchmark();
+                }
+            }
+        }
+        else
+        {
+            for (long iteration = 0; iteration < repeats; ++iteration)
+            {
+                for (Accumulator* ap = a.begin();  ap < a.end(); ++ap)
+                {
+                    ap->benchmark();
+                }
             }
         }
 
         // Accumulate all the partial sums to avoid dead code
         // elimination.
-        for (Accumulator* ap = a; ap < a + number_of_accumulators; ++ap)
+        int sum = 0;
+        for (Accumulator* ap = a.begin(); ap < a.end(); ++ap)
         {
-            live_code += ap->val;
+            sum += ap->val;
+        }
+        return sum;
+    }
+
+    template <class Accumulator>
+    void hammer(long const repeats)
+    {
+        accumulator_array<Accumulator> a(number_of_accumulators, shuffle_accumulators);
+        live_code = hammer(a, repeats);
+    }
+
+    // The counters of the benchmark thread, opened on first use.
+    inline perf_counters& counters()
+    {
+        static perf_counters c;
+        static bool warned = false;
+        if (!warned && !c.available())
+        {
+            std::cerr << "hardware counters unavailable "
+                "(see /proc/sys/kernel/perf_event_paranoid), timing only\n";
+            warned = true;
         }
+        return c;
     }
 
-    // Measure the time required to hammer accumulators of the given type
+    // Measure the time required to hammer accumulators of the given type,
+    // returns one elapsed time per sample. If counts is given and the
+    // counters are enabled, the events of all the samples are added to it.
     template <class Accumulator>
-    double measure(long const repeats)
+    std::vector<double> measure(long const repeats, double* counts = nullptr)
     {
         // Hammer accumulators a couple of times to ensure the
         // instruction cache is full of our test code, and that we don't
@@ -86,52 +256,293 @@ namespace test
         hammer<Accumulator>(repeats);
         hammer<Accumulator>(repeats);
 
-        // Now start a timer
-        util::high_resolution_timer time;
-        hammer<Accumulator>(repeats);   // This time, we'll measure
-        return time.elapsed();          // return the elapsed time
+        perf_counters* pc = counts && use_counters ? &counters() : nullptr;
+        std::vector<double> samples;
+        samples.reserve(number_of_samples);
+        for (int i = 0; i < number_of_samples; ++i)
+        {
+            if (pc)
+                pc->start();
+            // Now start a timer
+            util::cycle_timer time;
+            hammer<Accumulator>(repeats);   // This time, we'll measure
+            samples.push_back(time.elapsed());
+            if (pc)
+                pc->stop(counts);
+        }
+        return samples;
     }
     
+    // Ticks a cycle_timer reading of an empty interval takes.
+    inline std::uint64_t timer_overhead()
+    {
+        static std::uint64_t const overhead = []
+        {
+            histogram h;
+            for (int i = 0; i < 1000; ++i)
+            {
+                std::uint64_t const start = util::cycle_timer::begin_ticks();
+                h.record(util::cycle_timer::end_ticks() - start);
+            }
+            return std::uint64_t(h.percentile(50));
+        }();
+        return overhead;
+    }
+
+    // Time each accumulator's calls in batches of latency_batch, and
+    // collect the ticks per batch. The calls of a batch depend on each
+    // other through the accumulated value, so this measures latency rather
+    // than throughput, and the outliers (cold caches, preemption) show in
+    // the tail instead of being averaged away.
+    template <class Accumulator>
+    histogram measure_latency(long const repeats)
+    {
+        std::uint64_t const overhead = timer_overhead();
+        long const iterations = (std::max)(repeats / latency_batch, 1L);
+        accumulator_array<Accumulator> a(number_of_accumulators, shuffle_accumulators);
+        histogram h;
+
+        for (long iteration = 0; iteration < iterations; ++iteration)
+        {
+            for (std::size_t j = 0; j != number_of_accumulators; ++j)
+            {
+                Accumulator* const ap = a[j];
+                std::uint64_t const start = util::cycle_timer::begin_ticks();
+                for (int i = 0; i < latency_batch; ++i)
+                    ap->benchmark();
+                std::uint64_t const ticks = util::cycle_timer::end_ticks() - start;
+                h.record(ticks > overhead ? ticks - overhead : 0);
+            }
+        }
+
+        for (Accumulator* ap = a.begin(); ap < a.end(); ++ap)
+        {
+            live_code += ap->val;
+        }
+        return h;
+    }
+
+    // Copies the function object of an accumulator, for the accumulators
+    // holding it as f. The copy is made from a const reference, which the
+    // wrappers with a forwarding constructor would otherwise take for a
+    // callable.
+    template <class Accumulator, class = void>
+    struct function_copy
+    {
+        static bool make(Accumulator const&)
+        {
+            return false;
+        }
+    };
+
+    template <class Accumulator>
+    struct function_copy<Accumulator,
+        typename std::enable_if<
+            std::is_same<decltype(std::declval<Accumulator&>().f),
+                typename Accumulator::function_type>::value
+            && std::is_copy_constructible<typename Accumulator::function_type>::value
+        >::type>
+    {
+        static bool make(Accumulator const& acc)
+        {
+            typedef typename Accumulator::function_type function_type;
+            function_type const& f = acc.f;
+            function_type copy(f);
+            escape(copy);
+            return true;
+        }
+    };
+
+    // Heap allocations of the current (case, implementation) pair: per
+    // construction of an accumulator, per copy of its function object
+    // and per call once a pass over the working set has warmed it up.
+    template <class Accumulator>
+    void count_allocations(result& r)
+    {
+        allocation_stats at[number_of_allocation_points] = {};
+        double per[number_of_allocation_points] = {1, 1, 0};
+        bool measured[number_of_allocation_points] = {true, false, true};
+        {
+            allocation_stats const before = allocations;
+            Accumulator acc;
+            at[0] = allocations_since(before);
+            allocation_stats const before_copy = allocations;
+            measured[1] = function_copy<Accumulator>::make(acc);
+            at[1] = allocations_since(before_copy);
+            live_code += acc.val;
+        }
+        {
+            accumulator_array<Accumulator> a(number_of_accumulators, shuffle_accumulators);
+            live_code += hammer(a, 1);
+            allocation_stats const before = allocations;
+            live_code += hammer(a, 1);
+            at[2] = allocations_since(before);
+            per[2] = double(number_of_accumulators)
+                * calls_per_benchmark<Accumulator>::value;
+        }
+        for (int i = 0; i < number_of_allocation_points; ++i)
+        {
+            if (measured[i])
+            {
+                r.allocations[i] = at[i].count / per[i];
+                r.allocated_bytes[i] = at[i].bytes / per[i];
+            }
+        }
+    }
+
+    inline bool is_baseline(result const& r)
+    {
+        return r.name.find("no_abstraction") != std::string::npos;
+    }
+
     template <class Accumulator>
     void report(char const* name, long const repeats)
     {
+        result r;
+        r.name = name;
+        r.case_name = case_name;
+        r.implementation = implementation_name(name);
+        r.size = function_size<Accumulator>::value;
+        r.repeats = repeats;
+        r.accumulators = number_of_accumulators;
+        double counts[number_of_counters] = {};
+        r.samples = test::measure<Accumulator>(repeats, counts);
+        r.stats = summarize(r.samples);
+        r.calls = double(repeats) * number_of_accumulators
+            * calls_per_benchmark<Accumulator>::value;
+        r.ns_per_call = r.stats.median * 1e9 / r.calls;
+        r.cycles_per_call = r.stats.median * cycles_per_second() / r.calls;
+        if (use_counters)
+        {
+            for (int i = 0; i < number_of_counters; ++i)
+            {
+                if (counters().available(i))
+                    r.counters[i] = counts[i] / (r.calls * r.samples.size());
+            }
+            if (r.counters[cycles_counter] >= 0)
+                r.cycles_per_call = r.counters[cycles_counter];
+        }
+        if (use_latency)
+        {
+            histogram const h = measure_latency<Accumulator>(repeats);
+            double const ns_per_tick = 1e9 / util::cycle_timer::ticks_per_second()
+                / (latency_batch * calls_per_benchmark<Accumulator>::value);
+            for (int i = 0; i < number_of_percentiles; ++i)
+                r.latency[i] = h.percentile(percentile_point(i)) * ns_per_tick;
+        }
+
+        if (use_allocations)
+            count_allocations<Accumulator>(r);
+
         std::cout.precision(10);
         std::cout << name << ": ";
         for (int i = 0; i < (20-int(strlen(name))); ++i)
             std::cout << ' ';
-        std::cout << std::fixed << test::measure<Accumulator>(repeats) << " [s] ";
+        std::cout << std::fixed << r.stats.median << " [s] ";
+        std::cout << "{min: " << r.stats.min << ", mean: " << r.stats.mean
+            << ", stddev: " << r.stats.stddev << ", mad: " << r.stats.mad
+            << ", ci95: [" << r.stats.ci_low << ", " << r.stats.ci_high
+            << "]} ";
+        std::cout.precision(3);
+        std::cout << "{ns/call: " << r.ns_per_call;
+        if (r.cycles_per_call)
+            std::cout << ", cycles/call: " << r.cycles_per_call;
+        auto base = std::find_if(results.begin(), results.end(), is_baseline);
+        if (base != results.end() && !is_baseline(r))
+        {
+            double const over = r.ns_per_call - base->ns_per_call;
+            std::cout << ", overhead: " << std::showpos << over
+                << std::noshowpos << " ns";
+            if (base->cycles_per_call)
+                std::cout << " (" << std::showpos
+                    << r.cycles_per_call - base->cycles_per_call
+                    << std::noshowpos << " cycles)";
+        }
+        std::cout << "} ";
+        char const* sep = "{";
+        for (int i = 0; i < number_of_counters; ++i)
+        {
+            if (r.counters[i] >= 0)
+            {
+                std::cout << sep << counter_name(i) << "/call: " << r.counters[i];
+                sep = ", ";
+            }
+        }
+        if (*sep == ',')
+            std::cout << "} ";
+        sep = "{";
+        for (int i = 0; i < number_of_allocation_points; ++i)
+        {
+            if (r.allocations[i] >= 0)
+            {
+                std::cout << sep << "allocations/" << allocation_point_name(i)
+                    << ": " << r.allocations[i] << " (" << r.allocated_bytes[i]
+                    << " B)";
+                sep = ", ";
+            }
+        }
+        if (*sep == ',')
+            std::cout << "} ";
+        if (r.latency[0] >= 0)
+        {
+            std::cout << "{latency ns/call";
+            for (int i = 0; i < number_of_percentiles; ++i)
+                std::cout << (i ? ", " : " ") << percentile_name(i) << ": " << r.latency[i];
+            std::cout << "} ";
+        }
         Accumulator acc; 
         acc.benchmark(); 
-        std::cout << std::hex << "{checksum: " << acc.val << "}";
+        std::cout << std::hex << "{checksum: " << acc.val << "}" << std::dec;
         std::cout << std::flush << std::endl;
+
+        results.push_back(r);
+        for (auto& s : sinks)
+            s->write(r);
+    }
+
+    // Rank the results of the current benchmark by median, and point out
+    // the ones that can't be told apart.
+    inline void rank()
+    {
+        std::vector<result const*> order;
+        for (result const& r : results)
+            order.push_back(&r);
+        std::stable_sort(order.begin(), order.end(),
+            [](result const* a, result const* b)
+            {
+                return a->stats.median < b->stats.median;
+            });
+
+        std::cout << "ranking by median (~ n: indistinguishable from #n):\n";
+        std::cout.precision(10);
+        for (std::size_t i = 0; i != order.size(); ++i)
+        {
+            std::cout << (i < 9 ? "  " : " ") << i + 1 << ". "
+                << order[i]->name << ": " << order[i]->stats.median << " [s]";
+            std::cout.precision(3);
+            std::cout << " (" << order[i]->ns_per_call << " ns/call)";
+            std::cout.precision(10);
+            char const* sep = " ~ ";
+            for (std::size_t j = 0; j != order.size(); ++j)
+            {
+                if (j != i && indistinguishable(order[i]->stats, order[j]->stats))
+                {
+                    std::cout << sep << j + 1;
+                    sep = ", ";
+                }
+            }
+            std::cout << "\n";
+        }
+        std::cout << std::flush;
     }
     
     struct base
     {
+        static const int calls_per_benchmark = 1;
+
         base() : val(0) {}
         int val;    // This is needed to avoid dead-code elimination
     };
-    
-#define BOOST_SPIRIT_TEST_HAMMER(r, data, elem)                     \
-    test::hammer<elem>(repeats);
-    /***/
-
-#define BOOST_SPIRIT_TEST_MEASURE(r, data, elem)                    \
-    test::report<elem>(BOOST_PP_STRINGIZE(elem), repeats);          \
-    /***/
-
-#define BOOST_SPIRIT_TEST_BENCHMARK(max_repeats, FSeq)              \
-    long repeats = 100;                                             \
-    double measured = 0;                                            \
-    while (measured < 2.0 && repeats <= max_repeats)                \
-    {                                                               \
-        repeats *= 10;                                              \
-        util::high_resolution_timer time;                           \
-        BOOST_PP_SEQ_FOR_EACH(BOOST_SPIRIT_TEST_HAMMER, _, FSeq)    \
-        measured = time.elapsed();                                  \
-    }                                                               \
-    BOOST_PP_SEQ_FOR_EACH(BOOST_SPIRIT_TEST_MEASURE, _, FSeq)       \
-    /***/
 }
 
 #endif
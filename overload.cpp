@@ -12,7 +12,8 @@
 #include "stdex.hpp"
 #include "cxx_function.hpp"
 #include "function2.hpp"
-#include "measure.hpp"  
+#include "registry.hpp"
+#include "command_line.hpp"
 
 
 #define MAX_REPEAT 100000
@@ -75,6 +76,9 @@ struct use_base<virtual_base&>
 template<class F>
 struct Perf : test::base
 {
+    static const int calls_per_benchmark = 3;
+    typedef F function_type;
+
     Perf()
       : f(h)
     {}
@@ -90,25 +94,34 @@ struct Perf : test::base
     functor<typename use_base<F>::type> h;
 };
 
-template<class... Sig>
-void benchmark()
-{
-    typedef functor<empty_base> no_abstraction;
-    
-    BOOST_SPIRIT_TEST_BENCHMARK(
-        MAX_REPEAT,
-        (Perf< no_abstraction >)
-        (Perf< stdex::function<Sig...> >)
-        (Perf< multifunction<Sig...> >)
-        (Perf< cxx_function::function<Sig...> >)
-        (Perf< fu2::function<Sig...> >)
-        (Perf< virtual_base& >)
-    )
-}
+typedef functor<empty_base> no_abstraction;
 
-int main(int /*argc*/, char* /*argv*/[])
+template<template<class...> class F>
+using overloaded = F<int(tag<0>), int(tag<1>), int(tag<2>)>;
+
+BENCHMARK_WRAPPER(no_abstraction)
+BENCHMARK_NAMED_WRAPPER("stdex::function<Sig...>", overloaded<stdex::function>)
+BENCHMARK_NAMED_WRAPPER("multifunction<Sig...>", overloaded<multifunction>)
+BENCHMARK_NAMED_WRAPPER("cxx_function::function<Sig...>", overloaded<cxx_function::function>)
+BENCHMARK_NAMED_WRAPPER("fu2::function<Sig...>", overloaded<fu2::function>)
+BENCHMARK_WRAPPER(virtual_base&)
+
+BENCHMARK_REGISTER(overload, Perf,
+    test::type_list<
+        no_abstraction,
+        overloaded<stdex::function>,
+        overloaded<multifunction>,
+        overloaded<cxx_function::function>,
+        overloaded<fu2::function>,
+        virtual_base&
+    >)
+
+int main(int argc, char* argv[])
 {
-    benchmark<int(tag<0>), int(tag<1>), int(tag<2>)>();
+    if (!test::parse_command_line(argc, argv))
+        return 2;
+
+    test::run_benchmarks(MAX_REPEAT);
 
     // This is ultimately responsible for preventing all the test code
     // from being optimized away.  Change this to return 0 and you
@@ -0,0 +1,165 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#if !defined(BENCHMARK_PERF_COUNTERS_HPP)
+#define BENCHMARK_PERF_COUNTERS_HPP
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace test
+{
+    // The hardware events read around the measured runs.
+    enum counter_id
+    {
+        cycles_counter,
+        instructions_counter,
+        branch_misses_counter,
+        l1i_misses_counter,
+        itlb_misses_counter,
+        number_of_counters
+    };
+
+    inline char const* counter_name(int id)
+    {
+        static char const* const names[number_of_counters] =
+            {"cycles", "instructions", "branch_misses", "l1i_misses", "itlb_misses"};
+        return names[id];
+    }
+
+    // Enables the counters, set by --counters.
+    bool use_counters = false;
+
+#if defined(__linux__)
+
+    ///////////////////////////////////////////////////////////////////////////
+    //
+    //  perf_counters
+    //      Hardware event counts of the calling thread through
+    //      perf_event_open. Each event is opened on its own, so that a
+    //      machine lacking some of them (e.g. a VM without iTLB events)
+    //      still gets the others. If the kernel denies access altogether
+    //      available() is false and the counts are left alone.
+    //
+    ///////////////////////////////////////////////////////////////////////////
+    class perf_counters
+    {
+    public:
+        perf_counters()
+        {
+            static std::uint64_t const configs[number_of_counters][2] =
+            {
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+                {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1I
+                    | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+                {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_ITLB
+                    | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)}
+            };
+
+            for (int i = 0; i < number_of_counters; ++i)
+            {
+                perf_event_attr attr;
+                std::memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = std::uint32_t(configs[i][0]);
+                attr.config = configs[i][1];
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+                    | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                fds[i] = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+            }
+        }
+
+        ~perf_counters()
+        {
+            for (int fd : fds)
+            {
+                if (fd != -1)
+                    close(fd);
+            }
+        }
+
+        perf_counters(perf_counters const&) = delete;
+        perf_counters& operator=(perf_counters const&) = delete;
+
+        bool available() const
+        {
+            for (int fd : fds)
+            {
+                if (fd != -1)
+                    return true;
+            }
+            return false;
+        }
+
+        bool available(int id) const
+        {
+            return fds[id] != -1;
+        }
+
+        void start()
+        {
+            for (int fd : fds)
+            {
+                if (fd != -1)
+                {
+                    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+        }
+
+        // Adds the counts since start() to counts, events that aren't
+        // available are skipped.
+        void stop(double* counts)
+        {
+            for (int fd : fds)
+            {
+                if (fd != -1)
+                    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+
+            for (int i = 0; i < number_of_counters; ++i)
+            {
+                // value, time enabled, time running
+                std::uint64_t v[3];
+                if (fds[i] == -1 || read(fds[i], v, sizeof(v)) != sizeof(v))
+                    continue;
+
+                // Scale the count up if the event was multiplexed.
+                counts[i] += v[2] ? double(v[0]) * v[1] / v[2] : 0;
+            }
+        }
+
+    private:
+        int fds[number_of_counters];
+    };
+
+#else
+
+    // No counters on this platform, timing only.
+    class perf_counters
+    {
+    public:
+        bool available() const { return false; }
+        bool available(int) const { return false; }
+        void start() {}
+        void stop(double*) {}
+    };
+
+#endif
+}
+
+#endif
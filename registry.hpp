@@ -0,0 +1,264 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#if !defined(BENCHMARK_REGISTRY_HPP)
+#define BENCHMARK_REGISTRY_HPP
+
+#include "measure.hpp"
+#include "scaling.hpp"
+#include "cycle_timer.hpp"
+#include <iostream>
+#include <algorithm>
+#include <regex>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <boost/preprocessor/cat.hpp>
+
+namespace test
+{
+    template <class... T>
+    struct type_list {};
+
+    template <class... Lists>
+    struct concat;
+
+    template <>
+    struct concat<>
+    {
+        typedef type_list<> type;
+    };
+
+    template <class... T>
+    struct concat<type_list<T...> >
+    {
+        typedef type_list<T...> type;
+    };
+
+    template <class... T, class... U, class... Rest>
+    struct concat<type_list<T...>, type_list<U...>, Rest...>
+      : concat<type_list<T...,  U...>, Rest...>
+    {};
+
+    // The types of List for which Pred<T>::value holds.
+    template <template <class> class Pred, class List>
+    struct filter;
+
+    template <template <class> class Pred>
+    struct filter<Pred, type_list<> >
+    {
+        typedef type_list<> type;
+    };
+
+    template <template <class> class Pred, class T, class... Rest>
+    struct filter<Pred, type_list<T, Rest...> >
+      : concat<
+            typename std::conditional<Pred<T>::value, type_list<T>, type_list<> >::type,
+            typename filter<Pred, type_list<Rest...> >::type
+        >
+    {};
+
+    // Name of an implementation as reported, declared once per wrapper
+    // with BENCHMARK_WRAPPER.
+    template <class F>
+    struct wrapper_name;
+
+    struct benchmark_entry
+    {
+        std::string case_name;
+        std::string implementation;
+        std::string name;   // as printed, "Perf< implementation >"
+        void (*hammer)(long repeats);
+        void (*report)(char const* name, long repeats);
+        void (*report_scaling)(char const* name, long repeats);
+    };
+
+    // Every (case, implementation) pair, in registration order.
+    inline std::vector<benchmark_entry>& registry()
+    {
+        static std::vector<benchmark_entry> entries;
+        return entries;
+    }
+
+    // Set from the command line.
+    std::string case_filter;
+    std::string impl_filter;
+    long fixed_repeats = 0;
+    bool list_only = false;
+
+    // Working sets run by --sweep, from well inside L1 to far beyond the
+    // last level cache. Empty runs number_of_accumulators only.
+    std::vector<std::size_t> sweep_sizes;
+
+    inline std::vector<std::size_t> default_sweep()
+    {
+        std::vector<std::size_t> sizes;
+        for (std::size_t n = 64; n <= (std::size_t(1) << 22); n *= 4)
+            sizes.push_back(n);
+        return sizes;
+    }
+
+    // Registers Case<F> for every F of the list, the cross product is
+    // expanded at compile time.
+    template <template <class> class Case, class... F>
+    bool register_case(char const* case_name, type_list<F...>)
+    {
+        benchmark_entry const entries[] =
+        {
+            {
+                case_name, wrapper_name<F>::get(),
+                std::string("Perf< ") + wrapper_name<F>::get() + " >",
+                &hammer<Case<F> >, &report<Case<F> >, &report_scaling<Case<F> >
+            }...
+        };
+        registry().insert(registry().end(), entries, entries + sizeof...(F));
+        return true;
+    }
+
+    namespace detail
+    {
+        // Raises repeats (by tens, up to max_repeats) until one pass over
+        // the entries takes time_budget. Both bounds are for the default
+        // working set, and scaled to keep the calls per pass the same.
+        inline long calibrate(std::vector<benchmark_entry const*> const& entries,
+            long const max_repeats)
+        {
+            double const scale = double(default_accumulators) / number_of_accumulators;
+            long repeats = (std::max)(long(100 * scale), 1L);
+            long const limit = (std::max)(long(max_repeats * scale), 1L);
+            double measured = 0;
+            while (measured < time_budget && repeats <= limit)
+            {
+                repeats *= 10;
+                util::cycle_timer time;
+                for (benchmark_entry const* e : entries)
+                    e->hammer(repeats);
+                measured = time.elapsed();
+            }
+            return repeats;
+        }
+
+        inline void run_case(std::string const& name,
+            std::vector<benchmark_entry const*> const& entries, long const max_repeats)
+        {
+            case_name = name;
+            std::cout << "[" << case_name << "]\n";
+            results.clear();
+            long const repeats = fixed_repeats ? fixed_repeats : calibrate(entries, max_repeats);
+            if (max_threads)
+            {
+                for (benchmark_entry const* e : entries)
+                    e->report_scaling(e->name.c_str(), repeats);
+                std::cout << "\n";
+                return;
+            }
+            for (benchmark_entry const* e : entries)
+                e->report(e->name.c_str(), repeats);
+            rank();
+            std::cout << "\n";
+        }
+    }
+
+    // Runs the selected entries case by case: repeats are raised (by
+    // tens, up to max_repeats) until one pass over the case's
+    // implementations takes time_budget, then each is reported. With
+    // --sweep every case is run once per working set, as "case@size", and
+    // with --threads on 1 to max_threads threads, see report_scaling().
+    inline void run_benchmarks(long const max_repeats)
+    {
+        std::regex const case_re(case_filter), impl_re(impl_filter);
+        std::vector<benchmark_entry> const& all = registry();
+        for (std::size_t first = 0; first != all.size(); )
+        {
+            std::size_t last = first;
+            std::vector<benchmark_entry const*> entries;
+            for (; last != all.size() && all[last].case_name == all[first].case_name; ++last)
+            {
+                if (std::regex_search(all[last].case_name, case_re)
+                    && std::regex_search(all[last].implementation, impl_re))
+                    entries.push_back(&all[last]);
+            }
+            std::string const name = all[first].case_name;
+            first = last;
+            if (entries.empty())
+                continue;
+
+            if (list_only)
+            {
+                std::cout << "[" << name << "]\n";
+                for (benchmark_entry const* e : entries)
+                    std::cout << e->implementation << "\n";
+                std::cout << "\n";
+                continue;
+            }
+
+            if (sweep_sizes.empty())
+            {
+                detail::run_case(name, entries, max_repeats);
+                continue;
+            }
+
+            std::size_t const accumulators = number_of_accumulators;
+            for (std::size_t n : sweep_sizes)
+            {
+                number_of_accumulators = n;
+                detail::run_case(name + "@" + std::to_string(n), entries, max_repeats);
+            }
+            number_of_accumulators = accumulators;
+        }
+    }
+
+    namespace detail
+    {
+        template <class... F>
+        void show_sizes(type_list<F...>)
+        {
+            int const expand[] =
+            {
+                0, (std::cout << wrapper_name<F>::get() << ": " << sizeof(F) << "\n", 0)...
+            };
+            (void)expand;
+        }
+    }
+
+    // Prints sizeof every implementation of the list.
+    template <class List>
+    void show_sizes()
+    {
+        detail::show_sizes(List());
+    }
+}
+
+#define BENCHMARK_NAMED_WRAPPER(name, ...)                                      \
+    namespace test                                                              \
+    {                                                                           \
+        template <>                                                             \
+        struct wrapper_name<__VA_ARGS__>                                        \
+        {                                                                       \
+            static char const* get() { return name; }                           \
+        };                                                                      \
+    }                                                                           \
+    /***/
+
+#define BENCHMARK_WRAPPER(...)                                                  \
+    BENCHMARK_NAMED_WRAPPER(#__VA_ARGS__, __VA_ARGS__)                          \
+    /***/
+
+// Names every instantiation of a wrapper template for the signature Sig,
+// e.g. BENCHMARK_SIGNATURE_WRAPPER("fu2::function", fu2::function<Sig>).
+#define BENCHMARK_SIGNATURE_WRAPPER(name, ...)                                  \
+    namespace test                                                              \
+    {                                                                           \
+        template <class Sig>                                                    \
+        struct wrapper_name<__VA_ARGS__>                                        \
+        {                                                                       \
+            static char const* get() { return name; }                           \
+        };                                                                      \
+    }                                                                           \
+    /***/
+
+#define BENCHMARK_REGISTER(name, Case, ...)                                     \
+    static bool const BOOST_PP_CAT(benchmark_registered_, name) =               \
+        test::register_case<Case>(#name, test::concat<__VA_ARGS__>::type());    \
+    /***/
+
+#endif
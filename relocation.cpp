@@ -0,0 +1,224 @@
+#include "wrappers.hpp"
+#include "relocation.hpp"
+#include "command_line.hpp"
+
+#define MAX_REPEAT 100000
+
+// generic::delegate keeps the callable on the heap, and Function-rigtorp
+// swaps the bytes of its storage already.
+namespace test
+{
+    template<>
+    struct is_trivially_relocatable<generic_delegate>
+      : std::true_type
+    {};
+
+    template<>
+    struct is_trivially_relocatable<Function_>
+      : std::true_type
+    {};
+}
+
+// The wrappers in containers, built from a functor holding a reference:
+// small enough to be stored inline by most of them. Each case runs on
+// std::vector, and on test::relocating_vector, whose relocation fast path
+// the trivially relocatable wrappers take.
+namespace relocation
+{
+    const std::size_t elements = 32;
+
+    template<class F>
+    struct element_base : test::base
+    {
+        typedef F function_type;
+
+        static const int calls_per_benchmark = elements;
+
+        element_base()
+          : prototype(func2{a})
+        {}
+
+        // The copies are made from a const reference, which the wrappers
+        // with a forwarding constructor would otherwise take for a
+        // callable.
+        F const& source() const
+        {
+            return prototype;
+        }
+
+        int a = 2;
+        F prototype;
+    };
+
+    template<class F>
+    using std_vector = std::vector<F>;
+
+    template<class F>
+    using relocating_vector = test::relocating_vector<F>;
+
+    // Grows a vector from empty by pushing back copies of the prototype,
+    // then destroys it. Each call is one push_back.
+    template<template<class> class Vector, class F>
+    struct grow : element_base<F>
+    {
+        void benchmark()
+        {
+            Vector<F> v;
+            for (std::size_t i = 0; i != elements; ++i)
+                v.push_back(this->source());
+            test::escape(v);
+            this->val += v[elements / 2](this->val);
+        }
+    };
+
+    // Erases the middle element of a full vector and pushes it back, the
+    // elements after it moving down by one. Each call is one move.
+    template<template<class> class Vector, class F>
+    struct erase_middle : element_base<F>
+    {
+        static const int calls_per_benchmark = elements / 2;
+
+        erase_middle()
+        {
+            for (std::size_t i = 0; i != elements; ++i)
+                v.push_back(this->source());
+        }
+
+        void benchmark()
+        {
+            v.erase(v.begin() + elements / 2);
+            v.push_back(this->source());
+            test::escape(v);
+            this->val += v[elements / 2](this->val);
+        }
+
+        Vector<F> v;
+    };
+
+    // Sorts the elements by new random keys, as a timer queue would. On
+    // std::vector they're sorted along with their keys by std::sort, on
+    // relocating_vector the keys are sorted alone and the elements
+    // permuted after them. Each call is one element.
+    template<class F>
+    struct sort_by_key_std : element_base<F>
+    {
+        sort_by_key_std()
+        {
+            for (std::size_t i = 0; i != elements; ++i)
+                v.emplace_back(0, this->source());
+        }
+
+        void benchmark()
+        {
+            for (auto& e : v)
+                e.first = int(gen());
+            std::sort(v.begin(), v.end(),
+                [](std::pair<int, F> const& x, std::pair<int, F> const& y)
+                {
+                    return x.first < y.first;
+                });
+            test::escape(v);
+            this->val += v[elements / 2].second(this->val);
+        }
+
+        std::minstd_rand gen;
+        std::vector<std::pair<int, F> > v;
+    };
+
+    template<class F>
+    struct sort_by_key_relocating : element_base<F>
+    {
+        sort_by_key_relocating()
+        {
+            for (std::size_t i = 0; i != elements; ++i)
+                v.push_back(this->source());
+        }
+
+        void benchmark()
+        {
+            int keys[elements];
+            std::size_t order[elements];
+            for (std::size_t i = 0; i != elements; ++i)
+            {
+                keys[i] = int(gen());
+                order[i] = i;
+            }
+            std::sort(order, order + elements,
+                [&keys](std::size_t x, std::size_t y)
+                {
+                    return keys[x] < keys[y];
+                });
+            v.permute(order);
+            test::escape(v);
+            this->val += v[elements / 2](this->val);
+        }
+
+        std::minstd_rand gen;
+        relocating_vector<F> v;
+    };
+
+    template<class F>
+    using grow_std = grow<std_vector, F>;
+
+    template<class F>
+    using grow_relocating = grow<relocating_vector, F>;
+
+    template<class F>
+    using erase_middle_std = erase_middle<std_vector, F>;
+
+    template<class F>
+    using erase_middle_relocating = erase_middle<relocating_vector, F>;
+
+    // Which wrappers relocating_vector moves with memmove and realloc.
+    template<class... F>
+    void show_relocation(test::type_list<F...>)
+    {
+        char const* const names[] = {"", test::wrapper_name<F>::get()...};
+        bool const trivial[] = {false, test::is_trivially_relocatable<F>::value...};
+        for (int memcpy = 1; memcpy != -1; --memcpy)
+        {
+            std::cout << (memcpy ? "  trivially relocatable:" : "  move and destroy:    ");
+            char const* sep = " ";
+            for (std::size_t i = 1; i != sizeof...(F) + 1; ++i)
+            {
+                if (trivial[i] == (memcpy != 0))
+                {
+                    std::cout << sep << names[i];
+                    sep = ", ";
+                }
+            }
+            std::cout << "\n";
+        }
+    }
+}
+
+BENCHMARK_REGISTER(grow_std, relocation::grow_std,
+    wrappers::common, wrappers::optional)
+BENCHMARK_REGISTER(grow_relocating, relocation::grow_relocating,
+    wrappers::common, wrappers::optional)
+BENCHMARK_REGISTER(erase_middle_std, relocation::erase_middle_std,
+    wrappers::common, wrappers::optional)
+BENCHMARK_REGISTER(erase_middle_relocating, relocation::erase_middle_relocating,
+    wrappers::common, wrappers::optional)
+BENCHMARK_REGISTER(sort_by_key_std, relocation::sort_by_key_std,
+    wrappers::common, wrappers::optional)
+BENCHMARK_REGISTER(sort_by_key_relocating, relocation::sort_by_key_relocating,
+    wrappers::common, wrappers::optional)
+
+int main(int argc, char* argv[])
+{
+    if (!test::parse_command_line(argc, argv))
+        return 2;
+
+    if (!test::list_only)
+    {
+        std::cout << "[relocation]\n";
+        relocation::show_relocation(
+            test::concat<wrappers::common, wrappers::optional>::type());
+        std::cout << "\n";
+    }
+
+    test::run_benchmarks(MAX_REPEAT);
+
+    return test::live_code != 0;
+}
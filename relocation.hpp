@@ -0,0 +1,166 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#if !defined(BENCHMARK_RELOCATION_HPP)
+#define BENCHMARK_RELOCATION_HPP
+
+// Relocation, moving an object to another address and destroying the
+// original in one go, is what a container does to each of its elements
+// when it grows, erases or sorts. For most wrappers copying the bytes
+// would do, they are moved and destroyed one by one nonetheless.
+
+#include <new>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+
+namespace test
+{
+    // Whether copying the bytes of an F to another address, and forgetting
+    // the original instead of destroying it, relocates it. The trivially
+    // copyable types are, specialize it for the wrappers whose
+    // representation never points into itself.
+    template <class F>
+    struct is_trivially_relocatable
+      : std::is_trivially_copyable<F>
+    {};
+
+    // Relocates the n objects at first to the raw memory at dest. The
+    // ranges may overlap if dest comes before first.
+    template <class F>
+    inline void relocate(F* first, std::size_t n, F* dest, std::true_type)
+    {
+        std::memmove(static_cast<void*>(dest), static_cast<void const*>(first),
+            n * sizeof(F));
+    }
+
+    template <class F>
+    inline void relocate(F* first, std::size_t n, F* dest, std::false_type)
+    {
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            ::new (static_cast<void*>(dest + i)) F(std::move(first[i]));
+            first[i].~F();
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //
+    //  relocating_vector
+    //      The part of std::vector the relocation benchmarks use, moving
+    //      its elements by relocation: with memmove and realloc if the
+    //      elements are trivially relocatable, one by one otherwise. The
+    //      element pushed back must not be one of the vector's.
+    //
+    ///////////////////////////////////////////////////////////////////////////
+    template <class F, bool Relocatable = is_trivially_relocatable<F>::value>
+    class relocating_vector
+    {
+        static_assert(alignof(F) <= alignof(std::max_align_t),
+            "relocating_vector allocates with malloc");
+
+        typedef std::integral_constant<bool, Relocatable> relocatable;
+
+    public:
+        relocating_vector()
+          : first(nullptr), last(nullptr), end_of_storage(nullptr)
+        {}
+
+        ~relocating_vector()
+        {
+            clear();
+            std::free(first);
+        }
+
+        F* begin() const { return first; }
+        F* end() const { return last; }
+        std::size_t size() const { return last - first; }
+
+        F& operator[](std::size_t i) const
+        {
+            return first[i];
+        }
+
+        void push_back(F const& f)
+        {
+            if (last == end_of_storage)
+                reallocate(size() ? 2 * size() : 1);
+            ::new (static_cast<void*>(last)) F(f);
+            ++last;
+        }
+
+        F* erase(F* pos)
+        {
+            pos->~F();
+            relocate(pos + 1, last - pos - 1, pos, relocatable());
+            --last;
+            return pos;
+        }
+
+        void clear()
+        {
+            for (F* p = first; p != last; ++p)
+                p->~F();
+            last = first;
+        }
+
+        // Moves the element at order[i] to position i, for every i, in
+        // place: each cycle of the permutation takes one relocation per
+        // element and one more through a temporary. order is clobbered.
+        void permute(std::size_t* order)
+        {
+            typename std::aligned_storage<sizeof(F), alignof(F)>::type tmp;
+            F* const t = reinterpret_cast<F*>(&tmp);
+            std::size_t const n = size();
+            for (std::size_t i = 0; i != n; ++i)
+            {
+                if (order[i] == i)
+                    continue;
+                relocate(first + i, 1, t, relocatable());
+                std::size_t j = i;
+                for (std::size_t k = order[j]; k != i; k = order[j])
+                {
+                    relocate(first + k, 1, first + j, relocatable());
+                    order[j] = j;
+                    j = k;
+                }
+                relocate(t, 1, first + j, relocatable());
+                order[j] = j;
+            }
+        }
+
+    private:
+        relocating_vector(relocating_vector const&);
+        relocating_vector& operator=(relocating_vector const&);
+
+        void reallocate(std::size_t capacity)
+        {
+            std::size_t const n = size();
+            F* p;
+            if (Relocatable)
+            {
+                p = static_cast<F*>(std::realloc(first, capacity * sizeof(F)));
+                if (!p)
+                    throw std::bad_alloc();
+            }
+            else
+            {
+                p = static_cast<F*>(std::malloc(capacity * sizeof(F)));
+                if (!p)
+                    throw std::bad_alloc();
+                relocate(first, n, p, relocatable());
+                std::free(first);
+            }
+            first = p;
+            last = p + n;
+            end_of_storage = p + capacity;
+        }
+
+        F* first;
+        F* last;
+        F* end_of_storage;
+    };
+}
+
+#endif
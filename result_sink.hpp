@@ -0,0 +1,357 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#if !defined(BENCHMARK_RESULT_SINK_HPP)
+#define BENCHMARK_RESULT_SINK_HPP
+
+#include "statistics.hpp"
+#include "perf_counters.hpp"
+#include "histogram.hpp"
+#include "allocation.hpp"
+#include "cycle_timer.hpp"
+#include <boost/config.hpp>
+#include <boost/throw_exception.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <ctime>
+#include <cstddef>
+
+#if !defined(BENCHMARK_CXX_FLAGS)
+#define BENCHMARK_CXX_FLAGS "unknown"
+#endif
+
+namespace test
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //
+    //  result
+    //      Everything measured for one (case, implementation) pair.
+    //
+    ///////////////////////////////////////////////////////////////////////////
+    struct result
+    {
+        result()
+          : size(0), repeats(0), accumulators(0), threads(1), calls(0),
+            ns_per_call(0), cycles_per_call(0), compile_seconds(-1),
+            compile_peak_rss(-1), text_bytes(-1), symbols(-1)
+        {
+            for (double& c : counters)
+                c = -1;
+            for (double& l : latency)
+                l = -1;
+            for (int i = 0; i < number_of_allocation_points; ++i)
+                allocations[i] = allocated_bytes[i] = -1;
+        }
+
+        std::string name;           // as printed, e.g. "Perf< Delegate >"
+        std::string case_name;
+        std::string implementation;
+        std::size_t size;           // sizeof the function object
+        long repeats;
+        std::size_t accumulators;   // working set, objects hammered in turn
+        unsigned threads;           // hammering at once, each its own set
+        std::vector<double> samples;
+        statistics stats;
+        double calls;           // invocations per sample
+        double ns_per_call;     // median based
+        double cycles_per_call; // 0 if the clock rate is unknown
+        double counters[number_of_counters];    // per call, -1 if not measured
+        double latency[number_of_percentiles];  // ns per call, -1 if not measured
+        double allocations[number_of_allocation_points];     // -1 if not measured
+        double allocated_bytes[number_of_allocation_points]; // -1 if not measured
+        // Building the code_size translation units, -1 if not measured.
+        double compile_seconds;
+        double compile_peak_rss;    // kB
+        double text_bytes;          // executable sections of the object file
+        double symbols;             // functions and objects it defines
+    };
+
+    // Name of the case currently being run, set by the benchmark drivers.
+    std::string case_name = "benchmark";
+
+    // "Perf< X >" -> "X", other names are returned as is.
+    inline std::string implementation_name(std::string const& name)
+    {
+        std::string::size_type const open = name.find('<');
+        std::string::size_type const close = name.rfind('>');
+        if (open == std::string::npos || close != name.size() - 1)
+            return name;
+
+        std::string::size_type const first = name.find_first_not_of(' ', open + 1);
+        std::string::size_type const last = name.find_last_not_of(' ', close - 1);
+        return name.substr(first, last - first + 1);
+    }
+
+    struct run_metadata
+    {
+        std::string compiler;
+        std::string flags;
+        std::string platform;
+        std::string cpu;
+        std::string timer;
+        std::string date;
+    };
+
+    inline std::string cpu_name()
+    {
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        while (std::getline(cpuinfo, line))
+        {
+            if (line.compare(0, 10, "model name") == 0)
+            {
+                std::string::size_type const colon = line.find(':');
+                if (colon != std::string::npos && colon + 2 <= line.size())
+                    return line.substr(colon + 2);
+            }
+        }
+        return "unknown";
+    }
+
+    inline run_metadata const& metadata()
+    {
+        static run_metadata const md = []
+        {
+            run_metadata md;
+            md.compiler = BOOST_COMPILER;
+            md.flags = BENCHMARK_CXX_FLAGS;
+            md.platform = BOOST_PLATFORM;
+            md.cpu = cpu_name();
+            std::ostringstream timer;
+            timer << util::cycle_timer::source() << " @ "
+                << util::cycle_timer::ticks_per_second() * 1e-6 << " MHz";
+            md.timer = timer.str();
+            char buf[32];
+            std::time_t const now = std::time(nullptr);
+            std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+            md.date = buf;
+            return md;
+        }();
+        return md;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    //
+    //  sink
+    //      Receives every result as it's reported. The output is complete
+    //      once the sink is destroyed.
+    //
+    ///////////////////////////////////////////////////////////////////////////
+    struct sink
+    {
+        virtual ~sink() {}
+        virtual void write(result const& r) = 0;
+    };
+
+    // Sinks installed by the command line, see report().
+    std::vector<std::unique_ptr<sink> > sinks;
+
+    class file_sink : public sink
+    {
+    protected:
+        explicit file_sink(std::string const& path)
+          : out(path.c_str())
+        {
+            if (!out)
+                boost::throw_exception(std::runtime_error("Couldn't open " + path));
+            out.precision(17);
+        }
+
+        std::ofstream out;
+    };
+
+    class json_sink : public file_sink
+    {
+    public:
+        explicit json_sink(std::string const& path)
+          : file_sink(path), first(true)
+        {
+            run_metadata const& md = metadata();
+            out << "{\n  \"metadata\": {"
+                << "\"compiler\": " << quote(md.compiler)
+                << ", \"flags\": " << quote(md.flags)
+                << ", \"platform\": " << quote(md.platform)
+                << ", \"cpu\": " << quote(md.cpu)
+                << ", \"timer\": " << quote(md.timer)
+                << ", \"date\": " << quote(md.date)
+                << "},\n  \"results\": [";
+        }
+
+        ~json_sink()
+        {
+            out << "\n  ]\n}\n";
+        }
+
+        void write(result const& r)
+        {
+            out << (first ? "\n" : ",\n") << "    {"
+                << "\"case\": " << quote(r.case_name)
+                << ", \"implementation\": " << quote(r.implementation)
+                << ", \"sizeof\": " << r.size
+                << ", \"repeats\": " << r.repeats
+                << ", \"accumulators\": " << r.accumulators
+                << ", \"threads\": " << r.threads
+                << ", \"calls\": " << r.calls
+                << ", \"median\": " << r.stats.median
+                << ", \"min\": " << r.stats.min
+                << ", \"mean\": " << r.stats.mean
+                << ", \"stddev\": " << r.stats.stddev
+                << ", \"mad\": " << r.stats.mad
+                << ", \"ci_low\": " << r.stats.ci_low
+                << ", \"ci_high\": " << r.stats.ci_high
+                << ", \"ns_per_call\": " << r.ns_per_call
+                << ", \"cycles_per_call\": " << r.cycles_per_call
+                << ", \"counters\": {";
+            char const* sep = "";
+            for (int i = 0; i < number_of_counters; ++i)
+            {
+                if (r.counters[i] >= 0)
+                {
+                    out << sep << quote(counter_name(i)) << ": " << r.counters[i];
+                    sep = ", ";
+                }
+            }
+            out << "}, \"latency_ns\": {";
+            sep = "";
+            for (int i = 0; i < number_of_percentiles; ++i)
+            {
+                if (r.latency[i] >= 0)
+                {
+                    out << sep << quote(percentile_name(i)) << ": " << r.latency[i];
+                    sep = ", ";
+                }
+            }
+            out << "}, \"allocations\": {";
+            sep = "";
+            for (int i = 0; i < number_of_allocation_points; ++i)
+            {
+                if (r.allocations[i] >= 0)
+                {
+                    out << sep << quote(allocation_point_name(i))
+                        << ": {\"count\": " << r.allocations[i]
+                        << ", \"bytes\": " << r.allocated_bytes[i] << "}";
+                    sep = ", ";
+                }
+            }
+            out << "}, \"build\": {";
+            if (r.compile_seconds >= 0)
+            {
+                out << "\"compile_s\": " << r.compile_seconds
+                    << ", \"peak_rss_kb\": " << r.compile_peak_rss
+                    << ", \"text_bytes\": " << r.text_bytes
+                    << ", \"symbols\": " << r.symbols;
+            }
+            out << "}, \"samples\": [";
+            for (std::size_t i = 0; i != r.samples.size(); ++i)
+                out << (i ? ", " : "") << r.samples[i];
+            out << "]}";
+            first = false;
+        }
+
+    private:
+        static std::string quote(std::string const& s)
+        {
+            std::string q = "\"";
+            for (char c : s)
+            {
+                if (c == '"' || c == '\\')
+                    q += '\\';
+                if (static_cast<unsigned char>(c) < 0x20)
+                    c = ' ';
+                q += c;
+            }
+            return q += '"';
+        }
+
+        bool first;
+    };
+
+    class csv_sink : public file_sink
+    {
+    public:
+        explicit csv_sink(std::string const& path)
+          : file_sink(path)
+        {
+            out << "case,implementation,sizeof,repeats,accumulators,threads,calls,"
+                   "median,min,mean,stddev,mad,ci_low,ci_high,ns_per_call,cycles_per_call,";
+            for (int i = 0; i < number_of_counters; ++i)
+                out << counter_name(i) << ',';
+            for (int i = 0; i < number_of_percentiles; ++i)
+                out << "latency_" << percentile_name(i) << "_ns,";
+            for (int i = 0; i < number_of_allocation_points; ++i)
+            {
+                out << "allocations_per_" << allocation_point_name(i) << ','
+                    << "bytes_per_" << allocation_point_name(i) << ',';
+            }
+            out << "compile_s,peak_rss_kb,text_bytes,symbols,"
+                   "samples,compiler,flags,platform,cpu,timer,date\n";
+        }
+
+        void write(result const& r)
+        {
+            run_metadata const& md = metadata();
+            out << quote(r.case_name) << ',' << quote(r.implementation) << ','
+                << r.size << ',' << r.repeats << ',' << r.accumulators << ','
+                << r.threads << ',' << r.calls << ','
+                << r.stats.median << ',' << r.stats.min << ','
+                << r.stats.mean << ',' << r.stats.stddev << ','
+                << r.stats.mad << ',' << r.stats.ci_low << ','
+                << r.stats.ci_high << ',' << r.ns_per_call << ','
+                << r.cycles_per_call << ',';
+            for (int i = 0; i < number_of_counters; ++i)
+            {
+                if (r.counters[i] >= 0)
+                    out << r.counters[i];
+                out << ',';
+            }
+            for (int i = 0; i < number_of_percentiles; ++i)
+            {
+                if (r.latency[i] >= 0)
+                    out << r.latency[i];
+                out << ',';
+            }
+            for (int i = 0; i < number_of_allocation_points; ++i)
+            {
+                if (r.allocations[i] >= 0)
+                    out << r.allocations[i] << ',' << r.allocated_bytes[i];
+                else
+                    out << ',';
+                out << ',';
+            }
+            if (r.compile_seconds >= 0)
+            {
+                out << r.compile_seconds << ',' << r.compile_peak_rss << ','
+                    << r.text_bytes << ',' << r.symbols << ',';
+            }
+            else
+                out << ",,,,";
+            std::ostringstream samples;
+            samples.precision(17);
+            for (std::size_t i = 0; i != r.samples.size(); ++i)
+                samples << (i ? ";" : "") << r.samples[i];
+            out << quote(samples.str()) << ',' << quote(md.compiler) << ','
+                << quote(md.flags) << ',' << quote(md.platform) << ','
+                << quote(md.cpu) << ',' << quote(md.timer) << ','
+                << quote(md.date) << '\n';
+        }
+
+    private:
+        static std::string quote(std::string const& s)
+        {
+            std::string q = "\"";
+            for (char c : s)
+            {
+                if (c == '"')
+                    q += '"';
+                q += c;
+            }
+            return q += '"';
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,362 @@
+#include "wrappers.hpp"
+#include "command_line.hpp"
+
+#define MAX_REPEAT 100000
+
+// Results passed back through the wrappers: nothing, a std::string, a
+// 48-byte aggregate, a reference and a move-only pointer, returned by
+// a function pointer and by a capturing lambda. The [copies] table
+// counts the copies and moves each wrapper adds to the call's own.
+namespace returns
+{
+    // A move-only result that owns nothing, so returning it costs the
+    // moves and not an allocation.
+    struct no_delete
+    {
+        void operator()(int*) const {}
+    };
+
+    typedef std::unique_ptr<int, no_delete> unique_int;
+
+    struct agg48
+    {
+        int v[12];
+    };
+
+    // Where the results that don't carry the value are left, one per
+    // kind of result.
+    int void_sink;
+    int ref_sink;
+    int ptr_sink;
+
+    // Per result: plain(), which the callables end up in, and call(),
+    // which invokes a wrapper and reads the value back from the result.
+    struct void_result
+    {
+        typedef void result_type;
+
+        static void plain(int val)
+        {
+            void_sink = val * 2;
+        }
+
+        template<class F>
+        static int call(F& f, int val)
+        {
+            f(val);
+            return void_sink;
+        }
+    };
+
+    struct string
+    {
+        typedef std::string result_type;
+
+        static std::string plain(int val)
+        {
+            std::string s("a string");
+            s[0] = char(val);
+            return s;
+        }
+
+        template<class F>
+        static int call(F& f, int val)
+        {
+            return f(val)[0];
+        }
+    };
+
+    struct aggregate
+    {
+        typedef agg48 result_type;
+
+        static agg48 plain(int val)
+        {
+            agg48 a = {};
+            a.v[0] = val * 2;
+            return a;
+        }
+
+        template<class F>
+        static int call(F& f, int val)
+        {
+            return f(val).v[0];
+        }
+    };
+
+    struct reference
+    {
+        typedef int& result_type;
+
+        static int& plain(int val)
+        {
+            ref_sink = val * 2;
+            return ref_sink;
+        }
+
+        template<class F>
+        static int call(F& f, int val)
+        {
+            return f(val);
+        }
+    };
+
+    struct unique_ptr
+    {
+        typedef unique_int result_type;
+
+        static unique_int plain(int val)
+        {
+            ptr_sink = val * 2;
+            return unique_int(&ptr_sink);
+        }
+
+        template<class F>
+        static int call(F& f, int val)
+        {
+            return *f(val);
+        }
+    };
+
+    // Counts its copies and moves, 48 bytes like agg48. move_only_tracked
+    // can only be moved.
+    struct tracked
+    {
+        static int copies;
+        static int moves;
+
+        tracked()
+          : v()
+        {}
+
+        tracked(tracked const& other)
+        {
+            ++copies;
+            std::copy(other.v, other.v + 12, v);
+        }
+
+        tracked(tracked&& other)
+        {
+            ++moves;
+            std::copy(other.v, other.v + 12, v);
+        }
+
+        tracked& operator=(tracked const& other)
+        {
+            ++copies;
+            std::copy(other.v, other.v + 12, v);
+            return *this;
+        }
+
+        tracked& operator=(tracked&& other)
+        {
+            ++moves;
+            std::copy(other.v, other.v + 12, v);
+            return *this;
+        }
+
+        int v[12];
+    };
+
+    int tracked::copies = 0;
+    int tracked::moves = 0;
+
+    struct move_only_tracked : tracked
+    {
+        move_only_tracked() = default;
+        move_only_tracked(move_only_tracked&&) = default;
+        move_only_tracked& operator=(move_only_tracked&&) = default;
+    };
+
+    template<class T>
+    struct counted
+    {
+        typedef T result_type;
+
+        static T plain(int val)
+        {
+            T t;
+            t.v[0] = val * 2;
+            return t;
+        }
+    };
+
+    // Whether the wrapper W can return the result of Result: Delegate
+    // default constructs its result, which a reference can't be, and the
+    // invocation table of fu2 returns a copy of it.
+    template<class W, class Result>
+    struct returns
+      : std::true_type
+    {};
+
+    template<>
+    struct returns<delegate::Delegate<int&, int>, reference>
+      : std::false_type
+    {};
+
+    template<>
+    struct returns<fu2::function<int&(int)>, reference>
+      : std::false_type
+    {};
+
+    template<class Result>
+    struct returning
+    {
+        template<class W>
+        using holds = returns<W, Result>;
+
+        typedef typename test::concat<
+            wrappers::baseline,
+            typename test::filter<holds,
+                typename wrappers::for_signature<typename Result::result_type(int)>::type
+            >::type
+        >::type type;
+    };
+
+    template<class Result, class F>
+    struct base : test::base
+    {
+        typedef F function_type;
+
+        template<class Fn>
+        explicit base(Fn&& fn)
+          : f(std::forward<Fn>(fn))
+        {}
+
+        void benchmark()
+        {
+            this->val += Result::call(f, this->val);
+        }
+
+        F f;
+    };
+
+    template<class Result>
+    using pointer = typename Result::result_type (*)(int);
+
+    template<class Result, class F>
+    struct function_pointer : base<Result, F>
+    {
+        function_pointer()
+          : base<Result, F>(&Result::plain)
+        {}
+    };
+
+    template<class Result>
+    struct function_pointer<Result, no_abstraction>
+      : function_pointer<Result, pointer<Result> >
+    {};
+
+    template<class Result>
+    auto capture(int a)
+    {
+        return [a](int val) -> typename Result::result_type
+        {
+            return Result::plain(val * a / 2);
+        };
+    }
+
+    template<class Result, class F>
+    struct lambda_capture : base<Result, F>
+    {
+        lambda_capture()
+          : base<Result, F>(capture<Result>(2))
+        {}
+    };
+
+    template<class Result>
+    struct lambda_capture<Result, no_abstraction>
+      : lambda_capture<Result, decltype(capture<Result>(2))>
+    {};
+
+    // Copies and moves of the result of one call of f.
+    template<class F>
+    std::pair<int, int> copies_of(F& f)
+    {
+        tracked::copies = tracked::moves = 0;
+        auto const r = f(1);
+        test::escape(r);
+        return std::make_pair(tracked::copies, tracked::moves);
+    }
+
+    template<class W, class Fn>
+    std::pair<int, int> copies_through(Fn fn)
+    {
+        W w(fn);
+        return copies_of(w);
+    }
+
+    inline void show_copies(char const* name,
+        std::pair<int, int> ptr, std::pair<int, int> lambda)
+    {
+        std::cout << "  " << name << ": "
+            << ptr.first << " copies, " << ptr.second << " moves (function pointer), "
+            << lambda.first << " copies, " << lambda.second << " moves (lambda)\n";
+    }
+
+    template<class T, class W>
+    void show_copies(char const* name)
+    {
+        show_copies(name,
+            copies_through<W>(&counted<T>::plain),
+            copies_through<W>(capture<counted<T> >(2)));
+    }
+
+    template<class T, class... W>
+    void show_copies(test::type_list<W...>)
+    {
+        pointer<counted<T> > ptr = &counted<T>::plain;
+        auto lambda = capture<counted<T> >(2);
+        show_copies("no_abstraction", copies_of(ptr), copies_of(lambda));
+        int const expand[] =
+        {
+            0, (show_copies<T, W>(test::wrapper_name<W>::get()), 0)...
+        };
+        (void)expand;
+    }
+}
+
+#define RETURN_KIND(kind, result)                                               \
+    namespace returns                                                           \
+    {                                                                           \
+        template<class F>                                                       \
+        using kind##_##result = kind<result, F>;                                \
+    }                                                                           \
+    BENCHMARK_REGISTER(kind##_##result, returns::kind##_##result,               \
+        returns::returning<returns::result>::type)                              \
+    /***/
+
+#define RETURN(result)                                                          \
+    RETURN_KIND(function_pointer, result)                                       \
+    RETURN_KIND(lambda_capture, result)                                         \
+    /***/
+
+RETURN(void_result)
+RETURN(string)
+RETURN(aggregate)
+RETURN(reference)
+RETURN(unique_ptr)
+
+#undef RETURN
+#undef RETURN_KIND
+
+int main(int argc, char* argv[])
+{
+    if (!test::parse_command_line(argc, argv))
+        return 2;
+
+    if (!test::list_only)
+    {
+        std::cout << "[copies]\n";
+        returns::show_copies<returns::tracked>(
+            wrappers::for_signature<returns::tracked(int)>::type());
+        std::cout << "\n[moves only]\n";
+        returns::show_copies<returns::move_only_tracked>(
+            wrappers::for_signature<returns::move_only_tracked(int)>::type());
+        std::cout << "\n";
+    }
+
+    test::run_benchmarks(MAX_REPEAT);
+
+    return test::live_code != 0;
+}
@@ -0,0 +1,210 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#if !defined(BENCHMARK_SCALING_HPP)
+#define BENCHMARK_SCALING_HPP
+
+#include "measure.hpp"
+#include "result_sink.hpp"
+#include "statistics.hpp"
+#include "clock_rate.hpp"
+#include "cycle_timer.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace test
+{
+    // Runs every benchmark on 1 to max_threads threads instead of
+    // reporting it single threaded, set by --threads.
+    unsigned max_threads = 0;
+
+    inline unsigned hardware_threads()
+    {
+        unsigned const n = std::thread::hardware_concurrency();
+        return n ? n : 1;
+    }
+
+    namespace detail
+    {
+        // Holds the threads until all of them are ready, so that they
+        // start hammering together.
+        class start_barrier
+        {
+        public:
+            explicit start_barrier(unsigned n)
+              : waiting(n)
+            {}
+
+            void wait()
+            {
+                std::unique_lock<std::mutex> lock(m);
+                if (--waiting == 0)
+                    released.notify_all();
+                else
+                    released.wait(lock, [this] { return waiting == 0; });
+            }
+
+        private:
+            std::mutex m;
+            std::condition_variable released;
+            unsigned waiting;
+        };
+
+        // The CPUs the process may run on, in order.
+        inline std::vector<int> const& allowed_cpus()
+        {
+            static std::vector<int> const cpus = []
+            {
+                std::vector<int> cpus;
+#if defined(__linux__)
+                cpu_set_t set;
+                if (sched_getaffinity(0, sizeof(set), &set) == 0)
+                {
+                    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+                        if (CPU_ISSET(cpu, &set))
+                            cpus.push_back(cpu);
+                }
+#endif
+                return cpus;
+            }();
+            return cpus;
+        }
+
+        // Pins the calling thread to the i-th allowed CPU, wrapping around
+        // if there are more threads than CPUs. Best effort: elsewhere the
+        // threads are left to the scheduler.
+        inline void pin_thread(unsigned i)
+        {
+#if defined(__linux__)
+            std::vector<int> const& cpus = allowed_cpus();
+            if (cpus.empty())
+                return;
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[i % cpus.size()], &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+            (void)i;
+#endif
+        }
+
+        struct thread_run
+        {
+            std::uint64_t begin;    // cycle_timer ticks
+            std::uint64_t end;
+            int sum;
+        };
+
+        // Hammers an array of accumulators per thread, on n pinned threads
+        // released together. The arrays are built by their own threads,
+        // one at a time as the constructors may share state.
+        template <class Accumulator>
+        std::vector<thread_run> hammer_on_threads(unsigned n, long const repeats)
+        {
+            std::vector<thread_run> runs(n);
+            start_barrier ready(n);
+            std::mutex construction;
+            auto work = [&](unsigned i)
+            {
+                pin_thread(i);
+                std::unique_ptr<accumulator_array<Accumulator> > a;
+                {
+                    std::lock_guard<std::mutex> lock(construction);
+                    a.reset(new accumulator_array<Accumulator>(
+                        number_of_accumulators, shuffle_accumulators));
+                }
+                ready.wait();
+                runs[i].begin = util::cycle_timer::begin_ticks();
+                runs[i].sum = hammer(*a, repeats);
+                runs[i].end = util::cycle_timer::end_ticks();
+            };
+
+            std::vector<std::thread> threads;
+            for (unsigned i = 0; i != n; ++i)
+                threads.emplace_back(work, i);
+            for (std::thread& t : threads)
+                t.join();
+            return runs;
+        }
+    }
+
+    // Weak scaling: each of 1 to max_threads threads makes the calls of a
+    // single threaded sample. Reports the aggregate and per thread
+    // throughput, and the efficiency against the single thread.
+    template <class Accumulator>
+    void report_scaling(char const* name, long const repeats)
+    {
+        double const calls = double(repeats) * number_of_accumulators
+            * calls_per_benchmark<Accumulator>::value;
+        double const seconds_per_tick = 1 / util::cycle_timer::ticks_per_second();
+
+        std::cout << name << ":\n"
+            << "  threads     Mcalls/s  Mcalls/s/thread  efficiency\n";
+        double single = 0;
+        for (unsigned n = 1; n <= max_threads; ++n)
+        {
+            detail::hammer_on_threads<Accumulator>(n, repeats);  // warm up
+
+            std::vector<double> walls, each;
+            for (int i = 0; i < number_of_samples; ++i)
+            {
+                std::vector<detail::thread_run> const runs =
+                    detail::hammer_on_threads<Accumulator>(n, repeats);
+                std::uint64_t begin = runs[0].begin, end = runs[0].end;
+                live_code = 0;
+                for (detail::thread_run const& run : runs)
+                {
+                    begin = (std::min)(begin, run.begin);
+                    end = (std::max)(end, run.end);
+                    each.push_back(double(run.end - run.begin) * seconds_per_tick);
+                    live_code += run.sum;
+                }
+                walls.push_back(double(end - begin) * seconds_per_tick);
+            }
+
+            result r;
+            r.name = name;
+            r.case_name = case_name + "/threads=" + std::to_string(n);
+            r.implementation = implementation_name(name);
+            r.size = function_size<Accumulator>::value;
+            r.repeats = repeats;
+            r.accumulators = number_of_accumulators;
+            r.threads = n;
+            r.samples = walls;
+            r.stats = summarize(r.samples);
+            r.calls = calls * n;
+            r.ns_per_call = r.stats.median * 1e9 / r.calls;
+            r.cycles_per_call = r.stats.median * cycles_per_second() / r.calls;
+
+            double const aggregate = r.calls / r.stats.median;
+            double const per_thread = calls / median_of(each);
+            if (n == 1)
+                single = aggregate;
+
+            std::cout << std::fixed << std::setprecision(3)
+                << std::setw(9) << n
+                << std::setw(13) << aggregate * 1e-6
+                << std::setw(17) << per_thread * 1e-6
+                << std::setw(12) << aggregate / (n * single)
+                << std::endl;
+
+            for (auto& s : sinks)
+                s->write(r);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,281 @@
+#include "wrappers.hpp"
+#include "command_line.hpp"
+#include <string_view>
+
+#define MAX_REPEAT 100000
+
+// The callables of various.cpp's function_pointer, lambda_capture and
+// heavy_functor cases, under the signatures of real callbacks instead of
+// int(int): what forwarding a view, a reference, a move-only argument,
+// a large POD or several arguments costs through each wrapper.
+namespace signatures
+{
+    // A move-only argument that owns nothing, so passing it costs the
+    // moves and not an allocation.
+    struct no_delete
+    {
+        void operator()(int*) const {}
+    };
+
+    typedef std::unique_ptr<int, no_delete> unique_int;
+
+    struct pod64
+    {
+        int v[16];
+    };
+
+    // Per signature: plain(), which the callables end up in, and call(),
+    // which invokes a wrapper with arguments made from the accumulated
+    // value and state of the accumulator's own.
+    struct string_view
+    {
+        typedef int type(std::string_view);
+
+        static int plain(std::string_view s)
+        {
+            return int(s.size()) + s[0];
+        }
+
+        template<class F>
+        int call(F& f, int val)
+        {
+            return f(std::string_view(s, 16 + (val & 7)));
+        }
+
+        char s[24] = "the quick brown fox jum";
+    };
+
+    struct vector_ref
+    {
+        typedef int type(std::vector<int> const&);
+
+        static int plain(std::vector<int> const& v)
+        {
+            return v[0] * 2;
+        }
+
+        template<class F>
+        int call(F& f, int val)
+        {
+            v[0] = val;
+            return f(v);
+        }
+
+        std::vector<int> v = std::vector<int>(8);
+    };
+
+    struct unique_ptr
+    {
+        typedef int type(unique_int);
+
+        static int plain(unique_int p)
+        {
+            return *p * 2;
+        }
+
+        template<class F>
+        int call(F& f, int val)
+        {
+            i = val;
+            return f(unique_int(&i));
+        }
+
+        int i;
+    };
+
+    struct pod
+    {
+        typedef int type(pod64);
+
+        static int plain(pod64 p)
+        {
+            return p.v[0] * 2 + p.v[15];
+        }
+
+        template<class F>
+        int call(F& f, int val)
+        {
+            p.v[0] = val;
+            return f(p);
+        }
+
+        pod64 p = {};
+    };
+
+    struct three_ints
+    {
+        typedef int type(int, int, int);
+
+        static int plain(int a, int b, int c)
+        {
+            return a * 2 + b - c;
+        }
+
+        template<class F>
+        int call(F& f, int val)
+        {
+            return f(val, val, val);
+        }
+    };
+
+    struct five_args
+    {
+        typedef int type(int, long, double, int const*, char);
+
+        static int plain(int a, long b, double c, int const* d, char e)
+        {
+            return a * 2 + int(b) - int(c) + *d - e;
+        }
+
+        template<class F>
+        int call(F& f, int val)
+        {
+            return f(val, long(val), double(val), &zero, '\0');
+        }
+
+        int zero = 0;
+    };
+
+    // Whether the wrapper W takes the signature of Signature: the vtable
+    // of inplace_function works out whether a call throws by passing the
+    // arguments as lvalues, which copies the move-only ones.
+    template<class W, class Signature>
+    struct takes
+      : std::true_type
+    {};
+
+    template<>
+    struct takes<stdext::inplace_function<unique_ptr::type, 40>, unique_ptr>
+      : std::false_type
+    {};
+
+    template<class Signature>
+    struct taking
+    {
+        template<class W>
+        using holds = takes<W, Signature>;
+
+        typedef typename test::concat<
+            wrappers::baseline,
+            typename test::filter<holds,
+                typename wrappers::for_signature<typename Signature::type>::type
+            >::type
+        >::type type;
+    };
+
+    template<class Signature, class F>
+    struct base : test::base
+    {
+        typedef F function_type;
+
+        template<class Fn>
+        explicit base(Fn&& fn)
+          : f(std::forward<Fn>(fn))
+        {}
+
+        void benchmark()
+        {
+            this->val += args.call(f, this->val);
+        }
+
+        Signature args;
+        F f;
+    };
+
+    template<class Signature, class F>
+    struct function_pointer : base<Signature, F>
+    {
+        function_pointer()
+          : base<Signature, F>(&Signature::plain)
+        {}
+    };
+
+    template<class Signature>
+    struct function_pointer<Signature, no_abstraction>
+      : function_pointer<Signature, typename Signature::type*>
+    {};
+
+    template<class Signature>
+    auto capture(int a)
+    {
+        return [a](auto&&... args)
+        {
+            return a / 2 * Signature::plain(std::forward<decltype(args)>(args)...);
+        };
+    }
+
+    template<class Signature, class F>
+    struct lambda_capture : base<Signature, F>
+    {
+        lambda_capture()
+          : base<Signature, F>(capture<Signature>(2))
+        {}
+    };
+
+    template<class Signature>
+    struct lambda_capture<Signature, no_abstraction>
+      : lambda_capture<Signature, decltype(capture<Signature>(2))>
+    {};
+
+    // func1 of wrappers.hpp for any signature.
+    template<class Signature>
+    struct heavy
+    {
+        template<class... A>
+        int operator()(A&&... args)
+        {
+            return Signature::plain(std::forward<A>(args)...);
+        }
+
+        int a[10];
+    };
+
+    template<class Signature, class F>
+    struct heavy_functor : base<Signature, F>
+    {
+        heavy_functor()
+          : base<Signature, F>(heavy<Signature>())
+        {}
+    };
+
+    template<class Signature>
+    struct heavy_functor<Signature, no_abstraction>
+      : heavy_functor<Signature, heavy<Signature> >
+    {};
+}
+
+#define SIGNATURE_KIND(kind, signature)                                         \
+    namespace signatures                                                        \
+    {                                                                           \
+        template<class F>                                                       \
+        using kind##_##signature = kind<signature, F>;                          \
+    }                                                                           \
+    BENCHMARK_REGISTER(kind##_##signature, signatures::kind##_##signature,      \
+        signatures::taking<signatures::signature>::type)                        \
+    /***/
+
+#define SIGNATURE(signature)                                                    \
+    SIGNATURE_KIND(function_pointer, signature)                                 \
+    SIGNATURE_KIND(lambda_capture, signature)                                   \
+    SIGNATURE_KIND(heavy_functor, signature)                                    \
+    /***/
+
+SIGNATURE(string_view)
+SIGNATURE(vector_ref)
+SIGNATURE(unique_ptr)
+SIGNATURE(pod)
+SIGNATURE(three_ints)
+SIGNATURE(five_args)
+
+#undef SIGNATURE
+#undef SIGNATURE_KIND
+
+int main(int argc, char* argv[])
+{
+    if (!test::parse_command_line(argc, argv))
+        return 2;
+
+    test::run_benchmarks(MAX_REPEAT);
+
+    return test::live_code != 0;
+}
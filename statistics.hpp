@@ -0,0 +1,105 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#if !defined(BENCHMARK_STATISTICS_HPP)
+#define BENCHMARK_STATISTICS_HPP
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstddef>
+
+namespace test
+{
+    ///////////////////////////////////////////////////////////////////////////
+    //
+    //  statistics
+    //      Summary of a set of independent timing samples. The confidence
+    //      interval is a percentile bootstrap of the median, which is robust
+    //      against the occasional sample disturbed by the OS.
+    //
+    ///////////////////////////////////////////////////////////////////////////
+    struct statistics
+    {
+        statistics()
+          : min(0), median(0), mean(0), stddev(0), mad(0), ci_low(0), ci_high(0)
+        {}
+
+        double min;
+        double median;
+        double mean;
+        double stddev;  // sample standard deviation
+        double mad;     // median absolute deviation
+        double ci_low;  // bootstrap confidence interval of the median
+        double ci_high;
+    };
+
+    // Median of the given values, the vector is reordered in place.
+    inline double median_of(std::vector<double>& v)
+    {
+        if (v.empty())
+            return 0;
+
+        std::size_t const half = v.size() / 2;
+        std::nth_element(v.begin(), v.begin() + half, v.end());
+        double const upper = v[half];
+        if (v.size() % 2)
+            return upper;
+
+        double const lower = *std::max_element(v.begin(), v.begin() + half);
+        return (lower + upper) / 2;
+    }
+
+    inline statistics summarize(std::vector<double> const& samples,
+        double confidence = 0.95, int resamples = 1000)
+    {
+        statistics s;
+        if (samples.empty())
+            return s;
+
+        std::vector<double> v(samples);
+        std::size_t const n = v.size();
+
+        s.min = *std::min_element(v.begin(), v.end());
+        s.mean = std::accumulate(v.begin(), v.end(), 0.0) / n;
+        s.median = median_of(v);
+
+        double sq = 0;
+        for (double x : samples)
+            sq += (x - s.mean) * (x - s.mean);
+        s.stddev = n > 1 ? std::sqrt(sq / (n - 1)) : 0;
+
+        for (std::size_t i = 0; i != n; ++i)
+            v[i] = std::abs(samples[i] - s.median);
+        s.mad = median_of(v);
+
+        // Fixed seed: the same samples always give the same interval.
+        std::mt19937 gen(5489u);
+        std::uniform_int_distribution<std::size_t> pick(0, n - 1);
+        std::vector<double> medians(resamples);
+        for (double& m : medians)
+        {
+            for (double& x : v)
+                x = samples[pick(gen)];
+            m = median_of(v);
+        }
+        std::sort(medians.begin(), medians.end());
+
+        double const tail = (1 - confidence) / 2;
+        std::size_t const lo = std::size_t(tail * (resamples - 1));
+        std::size_t const hi = std::size_t((1 - tail) * (resamples - 1) + 0.5);
+        s.ci_low = medians[lo];
+        s.ci_high = medians[hi];
+        return s;
+    }
+
+    // Two results whose confidence intervals overlap can't be ranked against
+    // each other with any confidence.
+    inline bool indistinguishable(statistics const& a, statistics const& b)
+    {
+        return a.ci_low <= b.ci_high && b.ci_low <= a.ci_high;
+    }
+}
+
+#endif
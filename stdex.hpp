@@ -12,6 +12,7 @@
 #include <type_traits>
 #include <typeinfo>
 #include <cstdint>
+#include <cstddef>
 // std::is_trivially_move_constructible is not well supported, so I resort to
 // Boost here :/
 #include <boost/type_traits/has_trivial_move_constructor.hpp>
@@ -72,15 +73,16 @@ namespace stdex { namespace detail
         return false;
     }
     
-    template<class T>
+    template<class T, std::size_t Capacity = sizeof(std::uintptr_t)>
     struct is_emplaceable
-      : std::integral_constant<bool, sizeof(T) <= sizeof(std::uintptr_t)
+      : std::integral_constant<bool, sizeof(T) <= Capacity
             && alignof(std::uintptr_t) % alignof(T) == 0
             && std::is_nothrow_move_constructible<T>::value
             && std::is_nothrow_destructible<T>::value>
     {};
     
-    template<class F, class Alloc = std::allocator<void>, class = void>
+    template<class F, class Alloc = std::allocator<void>,
+        std::size_t Capacity = sizeof(std::uintptr_t), class = void>
     struct function_manager
     {
         struct wrapper
@@ -177,9 +179,9 @@ namespace stdex { namespace detail
         }
     };
 
-    template<class F, class Alloc>
-    struct function_manager<F, Alloc,
-        typename std::enable_if<is_emplaceable<F>::value>::type>
+    template<class F, class Alloc, std::size_t Capacity>
+    struct function_manager<F, Alloc, Capacity,
+        typename std::enable_if<is_emplaceable<F, Capacity>::value>::type>
       : fwd_emplaceable<F>
     {
         static void create(std::uintptr_t* data, F& f, Alloc const& = Alloc())
@@ -226,12 +228,23 @@ namespace stdex { namespace detail
 
 namespace stdex
 {
+    // Capacity is the number of bytes stored inline, a multiple of
+    // sizeof(std::uintptr_t); larger targets are allocated.
+    template<std::size_t Capacity, class... Sig>
+    class basic_function;
+    
     template<class... Sig>
-    class function;
+    using function = basic_function<sizeof(std::uintptr_t), Sig...>;
     
-    template<>
-    class function<>
+    template<std::size_t Capacity>
+    class basic_function<Capacity>
     {
+        static_assert(Capacity >= sizeof(std::uintptr_t)
+            && Capacity % sizeof(std::uintptr_t) == 0,
+            "Capacity must be a multiple of sizeof(std::uintptr_t)");
+        
+        static const std::size_t words = Capacity / sizeof(std::uintptr_t);
+        
     protected:
         
         struct internal_tag {};
@@ -241,41 +254,41 @@ namespace stdex
           : std::integral_constant<bool, true>
         {};
         
-        explicit function(internal_tag) {}
+        explicit basic_function(internal_tag) {}
         
         template<class F, class Alloc>
-        function(internal_tag, F& f, Alloc const& alloc)
-          : _ctrl(detail::function_manager<F, Alloc>::ctrl)
+        basic_function(internal_tag, F& f, Alloc const& alloc)
+          : _ctrl(detail::function_manager<F, Alloc, Capacity>::ctrl)
         {
-            detail::function_manager<F, Alloc>::create(&_data, f, alloc);
+            detail::function_manager<F, Alloc, Capacity>::create(_data, f, alloc);
         }
         
         template<class... Sig>
-        function(internal_tag, function<Sig...>& other, bool& moved)
+        basic_function(internal_tag, basic_function<Capacity, Sig...>& other, bool& moved)
           : _ctrl(other._ctrl)
         {
-            moved = _ctrl(&other._data, &_data, detail::ctrl_code::move);
+            moved = _ctrl(other._data, _data, detail::ctrl_code::move);
         }
         
     public:
         
-        function() noexcept
+        basic_function() noexcept
           : _ctrl(detail::null_ctrl)
         {}
     
-        function(std::nullptr_t) noexcept
+        basic_function(std::nullptr_t) noexcept
           : _ctrl(detail::null_ctrl)
         {}
     
         template<class F, class Alloc = std::allocator<void> >
-        function(F f, Alloc const& alloc = Alloc())
-          : _ctrl(detail::function_manager<F, Alloc>::ctrl)
+        basic_function(F f, Alloc const& alloc = Alloc())
+          : _ctrl(detail::function_manager<F, Alloc, Capacity>::ctrl)
         {
-            detail::function_manager<F, Alloc>::create(&_data, f, alloc);
+            detail::function_manager<F, Alloc, Capacity>::create(_data, f, alloc);
         }
         
         template<class R2, class... T2s>
-        function(R2(*p)(T2s...)) noexcept
+        basic_function(R2(*p)(T2s...)) noexcept
         {
             if (p)
                 init_raw(p);
@@ -284,47 +297,47 @@ namespace stdex
         }
     
         // copy
-        function(function const& other)
+        basic_function(basic_function const& other)
           : _ctrl(other._ctrl)
         {
-            _ctrl(&other._data, &_data, detail::ctrl_code::copy);
+            _ctrl(other._data, _data, detail::ctrl_code::copy);
         }
     
         // copy from superset
         template<class... Sig>
-        function(function<Sig...> const& other)
+        basic_function(basic_function<Capacity, Sig...> const& other)
           : _ctrl(other._ctrl)
         {
-            _ctrl(&other._data, &_data, detail::ctrl_code::copy);
+            _ctrl(other._data, _data, detail::ctrl_code::copy);
         }
         
         // move / move from superset
         template<class... Sig>
-        function(function<Sig...>&& other) noexcept
+        basic_function(basic_function<Capacity, Sig...>&& other) noexcept
           : _ctrl(other._ctrl)
         {
-            if (_ctrl(&other._data, &_data, detail::ctrl_code::move))
+            if (_ctrl(other._data, _data, detail::ctrl_code::move))
                 other.init_null();
         }
         
-        function& operator=(function other) noexcept
+        basic_function& operator=(basic_function other) noexcept
         {
             swap(other);
             return *this;
         }
         
-        void swap(function& other) noexcept
+        void swap(basic_function& other) noexcept
         {
-            std::uintptr_t tmp;
-            _ctrl(&_data, &tmp, detail::ctrl_code::move);
-            other._ctrl(&other._data, &_data, detail::ctrl_code::move);
-            _ctrl(&tmp, &other._data, detail::ctrl_code::move);
+            std::uintptr_t tmp[words];
+            _ctrl(_data, tmp, detail::ctrl_code::move);
+            other._ctrl(other._data, _data, detail::ctrl_code::move);
+            _ctrl(tmp, other._data, detail::ctrl_code::move);
             std::swap(_ctrl, other._ctrl);
         }
                 
-        ~function()
+        ~basic_function()
         {
-            _ctrl(&_data, nullptr, detail::ctrl_code::del);
+            _ctrl(_data, nullptr, detail::ctrl_code::del);
         }
         
         explicit operator bool() const noexcept
@@ -336,7 +349,7 @@ namespace stdex
         {
             std::uintptr_t ret[2] =
                 {reinterpret_cast<std::uintptr_t>(&typeid(void))};
-            _ctrl(&_data, ret, detail::ctrl_code::get);
+            _ctrl(_data, ret, detail::ctrl_code::get);
             return *reinterpret_cast<std::type_info const*>(ret[0]);
         }
         
@@ -345,7 +358,7 @@ namespace stdex
         {
             std::uintptr_t ret[2] =
                 {reinterpret_cast<std::uintptr_t>(&typeid(void))};
-            _ctrl(&_data, ret, detail::ctrl_code::get);
+            _ctrl(_data, ret, detail::ctrl_code::get);
             if (*reinterpret_cast<std::type_info const*>(ret[0]) == typeid(T))
                 return reinterpret_cast<T*>(ret[1]);
             else
@@ -355,7 +368,7 @@ namespace stdex
         template<class T>
         T const* target() const noexcept
         {
-            return const_cast<function*>(this)->template target<T>();
+            return const_cast<basic_function*>(this)->template target<T>();
         }
     
         // dummy
@@ -367,8 +380,9 @@ namespace stdex
         template<class F>
         void init_raw(F f)
         {
-            _ctrl = detail::function_manager<F>::ctrl;
-            detail::function_manager<F>::create(&_data, f);
+            typedef detail::function_manager<F, std::allocator<void>, Capacity> manager;
+            _ctrl = manager::ctrl;
+            manager::create(_data, f);
         }
         
         void init_null()
@@ -376,21 +390,21 @@ namespace stdex
             _ctrl = detail::null_ctrl;
         }
         
-        void steal(function& other)
+        void steal(basic_function& other)
         {
             swap(other);
         }
         
         bool (*_ctrl)(std::uintptr_t*, std::uintptr_t*, detail::ctrl_code);
-        mutable std::uintptr_t _data; // may store small object inplace
+        mutable std::uintptr_t _data[words]; // may store small object inplace
     };
 
-    template<class R, class... Ts, class... Rest>
-    class function<R(Ts...), Rest...>
-      : function<Rest...> // avoid slicing
+    template<std::size_t Capacity, class R, class... Ts, class... Rest>
+    class basic_function<Capacity, R(Ts...), Rest...>
+      : basic_function<Capacity, Rest...> // avoid slicing
       , public detail::trampoline<R(std::uintptr_t, void*, Ts...)>
     {
-        typedef function<Rest...> base_type;
+        typedef basic_function<Capacity, Rest...> base_type;
         typedef detail::trampoline<R(std::uintptr_t, void*, Ts...)> caller;
         
     protected:
@@ -403,39 +417,39 @@ namespace stdex
              && base_type::template is_subset_of<T>::value>
         {};
         
-        explicit function(internal_tag tag)
+        explicit basic_function(internal_tag tag)
           : base_type(tag)
         {}
         
         template<class F, class Alloc>
-        function(internal_tag tag, F& f, Alloc const& alloc)
+        basic_function(internal_tag tag, F& f, Alloc const& alloc)
           : base_type(tag, f, alloc)
-          , caller(detail::function_manager<F, Alloc>::template fwd<R, Ts...>)
+          , caller(detail::function_manager<F, Alloc, Capacity>::template fwd<R, Ts...>)
         {}
     
         template<class... Sig>
-        function(internal_tag tag, function<Sig...>& other, bool& moved)
+        basic_function(internal_tag tag, basic_function<Capacity, Sig...>& other, bool& moved)
           : base_type(tag, other, moved), caller(other)
         {}
     
     public:
         
-        function() noexcept
+        basic_function() noexcept
           : caller(detail::bad_call<R, Ts...>)
         {}
     
-        function(std::nullptr_t) noexcept
+        basic_function(std::nullptr_t) noexcept
           : caller(detail::bad_call<R, Ts...>)
         {}
         
         template<class F, class Alloc = std::allocator<void> >
-        function(F f, Alloc const& alloc = Alloc())
+        basic_function(F f, Alloc const& alloc = Alloc())
           : base_type(internal_tag(), f, alloc)
-          , caller(detail::function_manager<F, Alloc>::template fwd<R, Ts...>)
+          , caller(detail::function_manager<F, Alloc, Capacity>::template fwd<R, Ts...>)
         {}
         
         template<class R2, class... T2s>
-        function(R2(*p)(T2s...)) noexcept
+        basic_function(R2(*p)(T2s...)) noexcept
           : base_type(internal_tag())
         {
             if (p)
@@ -445,34 +459,34 @@ namespace stdex
         }
 
         // copy
-        function(function const& other)
+        basic_function(basic_function const& other)
           : base_type(static_cast<base_type const&>(other)), caller(other)
         {}
 
         // copy from superset
         template<class... Sig>
-        function(function<Sig...> const& other, typename std::enable_if<
-            is_subset_of<function<Sig...> >::value>::type* = 0)
+        basic_function(basic_function<Capacity, Sig...> const& other, typename std::enable_if<
+            is_subset_of<basic_function<Capacity, Sig...> >::value>::type* = 0)
           : base_type(other), caller(other)
         {}
         
         // move / move from superset
         template<class... Sig>
-        function(function<Sig...>&& other, typename std::enable_if<is_subset_of<
-            function<Sig...> >::value, bool>::type moved = false) noexcept
+        basic_function(basic_function<Capacity, Sig...>&& other, typename std::enable_if<is_subset_of<
+            basic_function<Capacity, Sig...> >::value, bool>::type moved = false) noexcept
           : base_type(internal_tag(), other, moved), caller(other)
         {
             if (moved)
                 other.init_null();
         }
 
-        function& operator=(function other) noexcept
+        basic_function& operator=(basic_function other) noexcept
         {
             steal(other);
             return *this;
         }
         
-        void swap(function& other) noexcept
+        void swap(basic_function& other) noexcept
         {
             base_type::swap(other);
             std::swap(caller::f, other.caller::f);
@@ -481,7 +495,7 @@ namespace stdex
         R operator()(Ts... args) const
         {
             return
-                caller::f(this->_data, &this->_data, std::forward<Ts>(args)...);
+                caller::f(this->_data[0], this->_data, std::forward<Ts>(args)...);
         }
             
         using base_type::operator();
@@ -491,13 +505,14 @@ namespace stdex
 
     protected:
     
-        template<class... Sig>
-        friend class function;
+        template<std::size_t, class... Sig>
+        friend class basic_function;
         
         template<class F>
         void init_raw(F f)
         {
-            caller::f = detail::function_manager<F>::template fwd<R, Ts...>;
+            caller::f = detail::function_manager<F, std::allocator<void>,
+                Capacity>::template fwd<R, Ts...>;
             base_type::init_raw(f);
         }
         
@@ -507,39 +522,39 @@ namespace stdex
             base_type::init_null();
         }
         
-        void steal(function& other) noexcept
+        void steal(basic_function& other) noexcept
         {
             base_type::steal(other);
             caller::f = other.caller::f;
         }
     };
     
-    template<class... Sig>
-    inline void swap(function<Sig...>& a, function<Sig...>& b)
+    template<std::size_t Capacity, class... Sig>
+    inline void swap(basic_function<Capacity, Sig...>& a, basic_function<Capacity, Sig...>& b)
     {
         a.swap(b);
     }
     
-    template<class... Sig>
-    inline bool operator==(function<Sig...> const& f, std::nullptr_t)
+    template<std::size_t Capacity, class... Sig>
+    inline bool operator==(basic_function<Capacity, Sig...> const& f, std::nullptr_t)
     {
         return !f;
     }
     
-    template<class... Sig>
-    inline bool operator==(std::nullptr_t, function<Sig...> const& f)
+    template<std::size_t Capacity, class... Sig>
+    inline bool operator==(std::nullptr_t, basic_function<Capacity, Sig...> const& f)
     {
         return !f;
     }
     
-    template<class... Sig>
-    inline bool operator!=(function<Sig...> const& f, std::nullptr_t)
+    template<std::size_t Capacity, class... Sig>
+    inline bool operator!=(basic_function<Capacity, Sig...> const& f, std::nullptr_t)
     {
         return bool(f);
     }
 
-    template<class... Sig>
-    inline bool operator!=(std::nullptr_t, function<Sig...> const& f)
+    template<std::size_t Capacity, class... Sig>
+    inline bool operator!=(std::nullptr_t, basic_function<Capacity, Sig...> const& f)
     {
         return bool(f);
     }
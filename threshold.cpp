@@ -0,0 +1,255 @@
+#include "wrappers.hpp"
+#include "command_line.hpp"
+#include <iomanip>
+
+#define MAX_REPEAT 100000
+
+// Where each wrapper stops storing the callable inline: functors of 8 to
+// 256 bytes aligned on 8, and of 32 and 64 bytes aligned on 1 to 64, are
+// invoked through them and built into them at every point.
+namespace threshold
+{
+    // A functor of Size bytes aligned on Align, reading the last byte of
+    // its state on every call.
+    template<std::size_t Size, std::size_t Align>
+    struct alignas(Align) payload
+    {
+        int operator()(int val)
+        {
+            return val * 2 + data[Size - 1];
+        }
+
+        unsigned char data[Size];
+    };
+
+    // Whether the wrapper W can hold a Payload: the wrappers of a fixed
+    // capacity reject the callables they can't store inline with a
+    // static_assert.
+    template<class W, class Payload>
+    struct accepts
+      : std::true_type
+    {};
+
+    template<class Payload>
+    struct accepts<Function_, Payload>
+      : std::integral_constant<bool,
+            sizeof(Payload) <= 56 - 2 * sizeof(void*) && alignof(Payload) <= 8>
+    {};
+
+    template<class Payload>
+    struct accepts<embxx_util_StaticFunction, Payload>
+      : std::integral_constant<bool,
+            sizeof(Payload) <= 48 && alignof(Payload) <= alignof(void*)>
+    {};
+
+    template<class Payload>
+    struct accepts<inplace_function, Payload>
+      : std::integral_constant<bool,
+            sizeof(Payload) <= inplace_function::capacity::value
+            && inplace_function::alignment::value % alignof(Payload) == 0>
+    {};
+
+    template<class Payload>
+    struct accepts<fixed_size_function<int(int)>, Payload>
+      : std::integral_constant<bool,
+            sizeof(Payload) <= 128 - 4 * sizeof(void*)>
+    {};
+
+    template<class Payload>
+    struct accepts<Delegate, Payload>
+      : std::integral_constant<bool,
+            sizeof(Payload) <= DELEGATE_ARGS_SIZE
+            && DELEGATE_ARGS_ALIGN % alignof(Payload) == 0>
+    {};
+
+#ifdef ADD_GNR
+    template<class Payload>
+    struct accepts<gnr_forwarder, Payload>
+      : std::integral_constant<bool, sizeof(Payload) <= 48>
+    {};
+#endif
+
+    typedef test::concat<
+        wrappers::common, wrappers::stdex_capacities, wrappers::optional
+    >::type all;
+
+    template<class Payload>
+    struct accepting
+    {
+        template<class W>
+        using holds = accepts<W, Payload>;
+
+        typedef typename test::concat<
+            wrappers::baseline,
+            typename test::filter<holds, all>::type
+        >::type type;
+    };
+
+    // Calls the payload through the wrapper, no_abstraction calls it
+    // directly.
+    template<class Payload, class F>
+    struct invoke : cases::base<F>
+    {
+        invoke()
+          : cases::base<F>(Payload())
+        {}
+    };
+
+    template<class Payload>
+    struct invoke<Payload, no_abstraction> : cases::base<Payload>
+    {
+        invoke()
+          : cases::base<Payload>(Payload())
+        {}
+    };
+
+    // Builds the wrapper from a payload and destroys it again.
+    template<class Payload, class F>
+    struct construct : test::base
+    {
+        typedef F function_type;
+
+        void benchmark()
+        {
+            Payload p = Payload();
+            F f(p);
+            test::escape(f);
+            this->val += f(this->val) + 1;
+        }
+    };
+
+    template<class Payload>
+    struct construct<Payload, no_abstraction> : construct<Payload, Payload>
+    {};
+
+    // "inline" or "heap" depending on whether building a W from a
+    // Payload allocates, "-" if W doesn't take it.
+    template<class Payload, class W>
+    char const* storage_of(std::true_type)
+    {
+        std::size_t const before = test::allocations.count;
+        {
+            Payload p = Payload();
+            W w(p);
+            test::escape(w);
+        }
+        return test::allocations.count != before ? "heap" : "inline";
+    }
+
+    template<class Payload, class W>
+    char const* storage_of(std::false_type)
+    {
+        return "-";
+    }
+
+    struct column
+    {
+        std::string label;
+        std::vector<char const*> cells;     // one per wrapper of all
+    };
+
+    template<class Payload, class... W>
+    column storage_column(std::string const& label, test::type_list<W...>)
+    {
+        column c;
+        c.label = label;
+        c.cells = {storage_of<Payload, W>(accepts<W, Payload>())...};
+        return c;
+    }
+
+    inline std::vector<column (*)()>& columns()
+    {
+        static std::vector<column (*)()> columns;
+        return columns;
+    }
+
+    template<class... W>
+    void show_storage(test::type_list<W...>)
+    {
+        std::vector<std::string> const names = {test::wrapper_name<W>::get()...};
+        std::size_t width = 0;
+        for (std::string const& name : names)
+            width = (std::max)(width, name.size());
+
+        std::vector<column> table;
+        for (column (*make)() : columns())
+            table.push_back(make());
+
+        std::cout << std::string(width, ' ') << "  size/align\n";
+        std::cout << std::string(width, ' ');
+        for (column const& c : table)
+            std::cout << ' ' << std::setw(7) << c.label;
+        std::cout << "\n";
+        for (std::size_t i = 0; i != names.size(); ++i)
+        {
+            std::cout << names[i] << std::string(width - names[i].size(), ' ');
+            for (column const& c : table)
+                std::cout << ' ' << std::setw(7) << c.cells[i];
+            std::cout << "\n";
+        }
+    }
+}
+
+#define THRESHOLD(size, align)                                                  \
+    namespace threshold                                                         \
+    {                                                                           \
+        typedef payload<size, align> payload_##size##_##align;                  \
+                                                                                \
+        template<class F>                                                       \
+        using invoke_##size##_##align = invoke<payload_##size##_##align, F>;    \
+                                                                                \
+        template<class F>                                                       \
+        using construct_##size##_##align = construct<payload_##size##_##align, F>; \
+                                                                                \
+        typedef accepting<payload_##size##_##align>::type                       \
+            wrappers_##size##_##align;                                          \
+                                                                                \
+        inline column column_##size##_##align()                                 \
+        {                                                                       \
+            return storage_column<payload_##size##_##align>(#size "/" #align, all()); \
+        }                                                                       \
+    }                                                                           \
+    BENCHMARK_REGISTER(invoke_##size##_##align,                                 \
+        threshold::invoke_##size##_##align, threshold::wrappers_##size##_##align) \
+    BENCHMARK_REGISTER(construct_##size##_##align,                              \
+        threshold::construct_##size##_##align, threshold::wrappers_##size##_##align) \
+    static bool const column_registered_##size##_##align =                      \
+        (threshold::columns().push_back(&threshold::column_##size##_##align), true); \
+    /***/
+
+THRESHOLD(8, 8)
+THRESHOLD(16, 8)
+THRESHOLD(24, 8)
+THRESHOLD(32, 8)
+THRESHOLD(40, 8)
+THRESHOLD(48, 8)
+THRESHOLD(56, 8)
+THRESHOLD(64, 8)
+THRESHOLD(96, 8)
+THRESHOLD(128, 8)
+THRESHOLD(192, 8)
+THRESHOLD(256, 8)
+
+THRESHOLD(32, 1)
+THRESHOLD(32, 16)
+THRESHOLD(32, 32)
+THRESHOLD(64, 64)
+
+#undef THRESHOLD
+
+int main(int argc, char* argv[])
+{
+    if (!test::parse_command_line(argc, argv))
+        return 2;
+
+    if (!test::list_only)
+    {
+        std::cout << "[threshold]\n";
+        threshold::show_storage(threshold::all());
+        std::cout << "\n";
+    }
+
+    test::run_benchmarks(MAX_REPEAT);
+
+    return test::live_code != 0;
+}
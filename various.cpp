@@ -1,445 +1,196 @@
-#include <iostream>
-#include <random>
-#include <string>
-#include <chrono>
-#include <memory>
-#include <boost/type_erasure/any.hpp>
-#include <boost/type_erasure/builtin.hpp>
-#include <boost/type_erasure/callable.hpp>
-#include <boost/function.hpp>
-#include "function.h"
-#include "delegate.hpp"
-#include "stdex.hpp"
-#include "function2.hpp"
-#include "fixed_size_function.hpp"
-#include "embxx/StaticFunction.h"
-#include "Function-rigtorp.h"
-#include "cxx_function.hpp"
-#include "inplace_function.h"
-
-#define DELEGATE_ARGS_SIZE 40
-#define DELEGATE_ARGS_ALIGN 8
-#include "delegate.h"
-typedef delegate::Delegate<int, int> Delegate;
-
-// Some optional stuff...
-#ifdef ADD_SSVU
-#define OPT_SSVU
-#include "FastFunc.hpp"
-#else
-#define OPT_SSVU(...)
-#endif
-#ifdef ADD_CLUGSTON
-#define OPT_CLUGSTON
-#include "FastDelegate.h"
-typedef fastdelegate::FastDelegate1<int, int> FastDelegate1;
-#else
-#define OPT_CLUGSTON(...)
-#endif
-#ifdef ADD_GNR
-#define OPT_GNR
-#include "forwarder.hpp"
-typedef gnr::forwarder<int(int), 48> gnr_forwarder;
-#else
-#define OPT_GNR(...)
-#endif
-#ifdef ADD_FOLLY
-#define OPT_FOLLY
-#include "folly/Function.h"
-#else
-#endif
-#ifdef ADD_BDE
-#define OPT_BDE
-#include "bslstl_function.h"
-#else
-#define OPT_BDE(...)
-#endif
-
-// Measurement.
-#include "measure.hpp"  
+#include "wrappers.hpp"
+#include "command_line.hpp"
 
 #define MAX_REPEAT 100000
 
-struct no_abstraction;
-
-typedef generic::delegate<int(int)> generic_delegate;
-typedef embxx::util::StaticFunction<int(int), 48> embxx_util_StaticFunction;
-typedef Function<int(int), 56> Function_;
-typedef stdext::inplace_function<int(int), 40> inplace_function;
-
-template<class... Sig>
-using multifunction =
-    boost::type_erasure::any<
-        boost::mpl::vector<
-            boost::type_erasure::copy_constructible<>,
-            boost::type_erasure::typeid_<>,
-            boost::type_erasure::relaxed,
-            boost::type_erasure::callable<Sig>...
-        >
-    >;
-
-int plain(int val)
-{
-    return val * 2;
-}
-
-struct func1
-{
-    int operator()(int val)
-    {
-        return val * 2;
-    }
-    
-    int a[10];
-};
-
-struct func2
-{
-    int operator()(int val)
-    {
-        return val * a;
-    }
-    
-    int& a;
-};
-
-struct A
-{
-    A(): a(2) {}
-
-    int f(int val)
-    {
-        return val * a;
-    }
-    
-    int a;
-};
-
 namespace cases
 {
-    template<class F>
-    struct base : test::base
+    // The megamorphic cases fill the accumulator array with a mix of
+    // Kinds distinct target types, so that the indirect call in each
+    // wrapper sees many targets like the callback slot of an event loop,
+    // instead of the single one the branch predictor always gets right.
+    template<int I>
+    struct target
     {
-        base() {}
+        static int call(int val)
+        {
+            return val * 2 + I;
+        }
 
-        template<class Fn>
-        explicit base(Fn&& fn)
-          : f(std::forward<Fn>(fn))
-        {}
-        
-        void benchmark()
+        int operator()(int val) const
         {
-            this->val += f(this->val);
+            return call(val);
         }
-        
-        F f;
     };
 
-    template<class F>
-    struct function_pointer : base<F>
+    // How the kinds are laid out over the accumulator array.
+    struct round_robin
     {
-        function_pointer()
-          : base<F>(&plain)
-        {}
+        static std::vector<int> kinds(int n, int k)
+        {
+            std::vector<int> v(n);
+            for (int i = 0; i != n; ++i)
+                v[i] = i % k;
+            return v;
+        }
     };
-    
-    template<>
-    struct function_pointer<no_abstraction>
-      : function_pointer<int(*)(int)>
-    {};
 
-    template<class F>
-    struct compile_time_function_pointer : base<F>
+    struct random
     {
-        compile_time_function_pointer()
-          : base<F>(stdex::function_wrapper<int(int), &plain>())
-        {}
+        static std::vector<int> kinds(int n, int k)
+        {
+            std::vector<int> v = round_robin::kinds(n, k);
+            std::shuffle(v.begin(), v.end(), std::mt19937(5489u));
+            return v;
+        }
     };
-    
-    template<>
-    struct compile_time_function_pointer<generic_delegate>
-      : base<generic_delegate>
+
+    struct clustered
     {
-        compile_time_function_pointer()
-          : base<generic_delegate>(generic_delegate::from<&plain>())
-        {}
+        static std::vector<int> kinds(int n, int k)
+        {
+            std::vector<int> v(n);
+            for (int i = 0; i != n; ++i)
+                v[i] = int(long(i) * k / n);
+            return v;
+        }
     };
-    
-    template<>
-    struct compile_time_function_pointer<no_abstraction>
-      : compile_time_function_pointer<stdex::function_wrapper<int(int), &plain> >
-    {};
 
-    template<class F>
-    struct compile_time_delegate : base<F>
+    template<int I>
+    target<I> make_target(std::false_type)
     {
-        compile_time_delegate()
-          : base<F>(stdex::method_wrapper<A, int(int), &A::f>(&a))
-        {}
-        
-        A a;
-    };
-    
-    template<>
-    struct compile_time_delegate<generic_delegate>
-      : base<generic_delegate>
+        return target<I>();
+    }
+
+    template<int I>
+    auto make_target(std::true_type) -> int(*)(int)
     {
-        compile_time_delegate()
-          : base<generic_delegate>(generic_delegate::from<A, &A::f>(&a))
-        {}
-        
-        A a;
-    };
-    
-    template<>
-    struct compile_time_delegate<no_abstraction>
-      : compile_time_delegate<stdex::method_wrapper<A, int(int), &A::f> >
-    {};
-            
-    template<class F>
-    struct stateless_lambda : base<F>
+        return &target<I>::call;
+    }
+
+    template<class F, int I>
+    void assign_target(F& f)
     {
-        stateless_lambda()
-        {
-            this->f = [](int val)
-            {
-                return val * 2;
-            };
-        }
-    };
-    
-    template<class F>
-    struct lambda_capture : base<F>
+        f = make_target<I>(typename std::is_pointer<F>::type());
+    }
+
+    template<class F, int... I>
+    void assign_target(F& f, int kind, std::integer_sequence<int, I...>)
+    {
+        static void (* const assign[])(F&) = {&assign_target<F, I>...};
+        assign[kind](f);
+    }
+
+    template<class F, int Kinds, class Arrangement>
+    struct megamorphic : base<F>
     {
-        lambda_capture()
+        megamorphic()
         {
-            int a = 2;
-            this->f = [a](int val)
+            // The accumulators take the kinds in turn as they're
+            // constructed, in visiting order. The table follows the
+            // working set when it's swept.
+            static std::vector<int> kinds;
+            static std::size_t next = 0;
+            if (kinds.size() != test::number_of_accumulators)
             {
-                return val * a;
-            };
+                kinds = Arrangement::kinds(int(test::number_of_accumulators), Kinds);
+                next = 0;
+            }
+            assign_target(this->f, kinds[next++ % kinds.size()],
+                std::make_integer_sequence<int, Kinds>());
         }
     };
-    
-    template<class F>
-    struct heavy_functor : base<F>
-    {
-        heavy_functor()
-          : base<F>(func1())
-        {}
-    };
-    
-    template<class F>
-    struct non_assignable : base<F>
-    {
-        non_assignable()
-          : base<F>(func2{a})
-        {}
-        
-        int a = 2;
-    };
+
+    // The baseline calls the same targets through plain function pointers.
+    template<int Kinds, class Arrangement>
+    struct megamorphic<no_abstraction, Kinds, Arrangement>
+      : megamorphic<int(*)(int), Kinds, Arrangement>
+    {};
+
+#define MEGAMORPHIC(kinds, arrangement)                                         \
+    template<class F>                                                           \
+    using megamorphic_##kinds##_##arrangement =                                 \
+        megamorphic<F, kinds, arrangement>;                                     \
+    /***/
+
+    MEGAMORPHIC(2, round_robin)
+    MEGAMORPHIC(2, random)
+    MEGAMORPHIC(2, clustered)
+    MEGAMORPHIC(4, round_robin)
+    MEGAMORPHIC(4, random)
+    MEGAMORPHIC(4, clustered)
+    MEGAMORPHIC(16, round_robin)
+    MEGAMORPHIC(16, random)
+    MEGAMORPHIC(16, clustered)
+    MEGAMORPHIC(64, round_robin)
+    MEGAMORPHIC(64, random)
+    MEGAMORPHIC(64, clustered)
+
+#undef MEGAMORPHIC
 }
 
-#define DECLARE_BENCHMARK(name, list)                                           \
-template<template<class> class Perf>                                            \
-void benchmark_##name()                                                         \
-{                                                                               \
-    std::cout << "[" #name << "]\n";                                            \
-    BOOST_SPIRIT_TEST_BENCHMARK(                                                \
-        MAX_REPEAT,                                                             \
-        list                                                                    \
-    )                                                                           \
-    std::cout << "\n";                                                          \
-}                                                                               \
-/***/
 
-#define BENCHMARK(name) benchmark_##name<cases::name>()
-#define SHOW_SIZE(name) std::cout << #name << ": " << sizeof(name) << "\n"
+#define BENCHMARK(name, ...) BENCHMARK_REGISTER(name, cases::name, __VA_ARGS__)
 
-DECLARE_BENCHMARK(function_pointer,
-    (Perf< no_abstraction >)
-    (Perf< stdex::function<int(int)> >)
-    (Perf< std::function<int(int)> >)
-    (Perf< cxx_function::function<int(int)> >)
-    (Perf< multifunction<int(int)> >)
-    (Perf< boost::function<int(int)> >)
-    (Perf< func::function<int(int)> >)
-    (Perf< generic::delegate<int(int)> >)
-    (Perf< fu2::function<int(int)> >)
-    (Perf< fixed_size_function<int(int)> >)
-    (Perf< embxx_util_StaticFunction >)
-    (Perf< Function_ >)
-    (Perf< inplace_function >)
-    (Perf< Delegate >)
-    OPT_CLUGSTON(Perf< FastDelegate1 >)
-    OPT_SSVU(Perf< ssvu::FastFunc<int(int)> >)
-    OPT_GNR(Perf< gnr_forwarder >)
-    OPT_FOLLY(Perf< folly::Function<int(int)> >)
-    OPT_BDE(Perf< bsl::function<int(int)> >)
-)
+BENCHMARK(function_pointer,
+    wrappers::baseline, wrappers::common,
+    wrappers::fast_delegate, wrappers::fast_func, wrappers::optional)
 
-DECLARE_BENCHMARK(compile_time_function_pointer,
-    (Perf< no_abstraction >)
-    (Perf< stdex::function<int(int)> >)
-    (Perf< std::function<int(int)> >)
-    (Perf< cxx_function::function<int(int)> >)
-    (Perf< multifunction<int(int)> >)
-    (Perf< boost::function<int(int)> >)
-    (Perf< func::function<int(int)> >)
-    (Perf< generic::delegate<int(int)> >)
-    (Perf< fu2::function<int(int)> >)
-    (Perf< fixed_size_function<int(int)> >)
-    (Perf< embxx_util_StaticFunction >)
-    (Perf< Function_ >)
-    (Perf< inplace_function >)
-    (Perf< Delegate >)
-    //OPT_CLUGSTON(Perf< FastDelegate1 >)
-    //OPT_SSVU(Perf< ssvu::FastFunc<int(int)> >)
-    OPT_GNR(Perf< gnr_forwarder >)
-    OPT_FOLLY(Perf< folly::Function<int(int)> >)
-    OPT_BDE(Perf< bsl::function<int(int)> >)
-)
+BENCHMARK(compile_time_function_pointer,
+    wrappers::baseline, wrappers::common, wrappers::optional)
 
-DECLARE_BENCHMARK(compile_time_delegate,
-    (Perf< no_abstraction >)
-    (Perf< stdex::function<int(int)> >)
-    (Perf< std::function<int(int)> >)
-    (Perf< cxx_function::function<int(int)> >)
-    (Perf< multifunction<int(int)> >)
-    (Perf< boost::function<int(int)> >)
-    (Perf< func::function<int(int)> >)
-    (Perf< generic::delegate<int(int)> >)
-    (Perf< fu2::function<int(int)> >)
-    (Perf< fixed_size_function<int(int)> >)
-    (Perf< embxx_util_StaticFunction >)
-    (Perf< Function_ >)
-    (Perf< inplace_function >)
-    (Perf< Delegate >)
-    //OPT_CLUGSTON(Perf< FastDelegate1 >)
-    //OPT_SSVU(Perf< ssvu::FastFunc<int(int)> >)
-    OPT_GNR(Perf< gnr_forwarder >)
-    OPT_FOLLY(Perf< folly::Function<int(int)> >)
-    OPT_BDE(Perf< bsl::function<int(int)> >)
-)
+BENCHMARK(compile_time_delegate,
+    wrappers::baseline, wrappers::common, wrappers::optional)
 
-DECLARE_BENCHMARK(heavy_functor,
-    (Perf< stdex::function<int(int)> >)
-    (Perf< std::function<int(int)> >)
-    (Perf< cxx_function::function<int(int)> >)
-    (Perf< multifunction<int(int)> >)
-    (Perf< boost::function<int(int)> >)
-    (Perf< func::function<int(int)> >)
-    (Perf< generic::delegate<int(int)> >)
-    (Perf< fu2::function<int(int)> >)
-    (Perf< fixed_size_function<int(int)> >)
-    (Perf< embxx_util_StaticFunction >)
-    (Perf< Function_ >)
-    (Perf< inplace_function >)
-    (Perf< Delegate >)
-    //OPT_CLUGSTON(Perf< FastDelegate1 >)
-    //OPT_SSVU(Perf< ssvu::FastFunc<int(int)> >)
-    OPT_GNR(Perf< gnr_forwarder >)
-    OPT_FOLLY(Perf< folly::Function<int(int)> >)
-    OPT_BDE(Perf< bsl::function<int(int)> >)
-)
+BENCHMARK(heavy_functor,
+    wrappers::common, wrappers::optional)
 
-DECLARE_BENCHMARK(non_assignable,
-    (Perf< stdex::function<int(int)> >)
-    (Perf< std::function<int(int)> >)
-    (Perf< cxx_function::function<int(int)> >)
-    (Perf< multifunction<int(int)> >)
-    (Perf< boost::function<int(int)> >)
-    (Perf< func::function<int(int)> >)
-    (Perf< generic::delegate<int(int)> >)
-    (Perf< fu2::function<int(int)> >)
-    (Perf< fixed_size_function<int(int)> >)
-    (Perf< embxx_util_StaticFunction >)
-    (Perf< Function_ >)
-    (Perf< inplace_function >)
-    (Perf< Delegate >)
-    //OPT_CLUGSTON(Perf< FastDelegate1 >)
-    //OPT_SSVU(Perf< ssvu::FastFunc<int(int)> >)
-    OPT_GNR(Perf< gnr_forwarder >)
-    OPT_FOLLY(Perf< folly::Function<int(int)> >)
-    OPT_BDE(Perf< bsl::function<int(int)> >)
-)
+BENCHMARK(non_assignable,
+    wrappers::common, wrappers::optional)
 
-DECLARE_BENCHMARK(lambda_capture,
-    (Perf< stdex::function<int(int)> >)
-    (Perf< std::function<int(int)> >)
-    (Perf< cxx_function::function<int(int)> >)
-    (Perf< multifunction<int(int)> >)
-    (Perf< boost::function<int(int)> >)
-    (Perf< func::function<int(int)> >)
-    (Perf< generic::delegate<int(int)> >)
-    (Perf< fu2::function<int(int)> >)
-    (Perf< fixed_size_function<int(int)> >)
-    (Perf< embxx_util_StaticFunction >)
-    (Perf< Function_ >)
-    (Perf< inplace_function >)
-    (Perf< Delegate >)
-    //OPT_CLUGSTON(Perf< FastDelegate1 >)
-    OPT_SSVU(Perf< ssvu::FastFunc<int(int)> >)
-    OPT_GNR(Perf< gnr_forwarder >)
-    OPT_FOLLY(Perf< folly::Function<int(int)> >)
-    OPT_BDE(Perf< bsl::function<int(int)> >)
-)
+BENCHMARK(lambda_capture,
+    wrappers::common, wrappers::fast_func, wrappers::optional)
 
-DECLARE_BENCHMARK(stateless_lambda,
-    (Perf< stdex::function<int(int)> >)
-    (Perf< std::function<int(int)> >)
-    (Perf< cxx_function::function<int(int)> >)
-    (Perf< multifunction<int(int)> >)
-    (Perf< boost::function<int(int)> >)
-    (Perf< func::function<int(int)> >)
-    (Perf< generic::delegate<int(int)> >)
-    (Perf< fu2::function<int(int)> >)
-    (Perf< fixed_size_function<int(int)> >)
-    (Perf< embxx_util_StaticFunction >)
-    (Perf< Function_ >)
-    (Perf< inplace_function >)
-    (Perf< Delegate >)
-    OPT_CLUGSTON(Perf< FastDelegate1 >)
-    OPT_SSVU(Perf< ssvu::FastFunc<int(int)> >)
-    OPT_GNR(Perf< gnr_forwarder >)
-    OPT_FOLLY(Perf< folly::Function<int(int)> >)
-    OPT_BDE(Perf< bsl::function<int(int)> >)
-)
+BENCHMARK(stateless_lambda,
+    wrappers::common, wrappers::fast_delegate, wrappers::fast_func, wrappers::optional)
 
-int main(int /*argc*/, char* /*argv*/[])
+#define MEGAMORPHIC(kinds, arrangement)                                         \
+    BENCHMARK(megamorphic_##kinds##_##arrangement,                              \
+        wrappers::baseline, wrappers::common, wrappers::fast_func,             \
+        wrappers::optional)                                                     \
+    /***/
+
+MEGAMORPHIC(2, round_robin)
+MEGAMORPHIC(2, random)
+MEGAMORPHIC(2, clustered)
+MEGAMORPHIC(4, round_robin)
+MEGAMORPHIC(4, random)
+MEGAMORPHIC(4, clustered)
+MEGAMORPHIC(16, round_robin)
+MEGAMORPHIC(16, random)
+MEGAMORPHIC(16, clustered)
+MEGAMORPHIC(64, round_robin)
+MEGAMORPHIC(64, random)
+MEGAMORPHIC(64, clustered)
+
+#undef MEGAMORPHIC
+
+int main(int argc, char* argv[])
 {
-    std::cout << "[size]\n";
-    SHOW_SIZE(stdex::function<int(int)>);
-    SHOW_SIZE(std::function<int(int)>);
-    SHOW_SIZE(cxx_function::function<int(int)>);
-    SHOW_SIZE(multifunction<int(int)>);
-    SHOW_SIZE(boost::function<int(int)>);
-    SHOW_SIZE(func::function<int(int)>);
-    SHOW_SIZE(generic::delegate<int(int)>);
-    SHOW_SIZE(fu2::function<int(int)>);
-    SHOW_SIZE(fixed_size_function<int(int)>);
-    SHOW_SIZE(embxx_util_StaticFunction);
-    SHOW_SIZE(Function_);
-    SHOW_SIZE(inplace_function);
-    SHOW_SIZE(Delegate);
-    OPT_CLUGSTON(SHOW_SIZE(FastDelegate1));
-    OPT_SSVU(SHOW_SIZE(ssvu::FastFunc<int(int)>));
-    OPT_GNR(SHOW_SIZE(gnr_forwarder));
-    OPT_FOLLY(SHOW_SIZE(folly::Function<int(int)>));
-    OPT_BDE(SHOW_SIZE(bsl::function<int(int)>));
-    std::cout << "\n";
-    
-    BENCHMARK(function_pointer);
-    BENCHMARK(compile_time_function_pointer);
-    BENCHMARK(compile_time_delegate);
-    BENCHMARK(heavy_functor);
-    BENCHMARK(non_assignable);
-    BENCHMARK(lambda_capture);
-    BENCHMARK(stateless_lambda);
+    if (!test::parse_command_line(argc, argv))
+        return 2;
+
+    if (!test::list_only)
+    {
+        std::cout << "[size]\n";
+        test::show_sizes<wrappers::all>();
+        std::cout << "\n";
+    }
+
+    test::run_benchmarks(MAX_REPEAT);
     
     // This is ultimately responsible for preventing all the test code
     // from being optimized away.  Change this to return 0 and you
     // unplug the whole test's life support system.
     return test::live_code != 0;
 }
-
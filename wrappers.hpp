@@ -0,0 +1,382 @@
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#if !defined(BENCHMARK_WRAPPERS_HPP)
+#define BENCHMARK_WRAPPERS_HPP
+
+// The implementations under test, the callables they are built from and
+// the lists the benchmark programs register them with.
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <boost/type_erasure/any.hpp>
+#include <boost/type_erasure/builtin.hpp>
+#include <boost/type_erasure/callable.hpp>
+#include <boost/function.hpp>
+#include "function.h"
+#include "delegate.hpp"
+#include "stdex.hpp"
+#include "function2.hpp"
+#include "fixed_size_function.hpp"
+#include "embxx/StaticFunction.h"
+#include "Function-rigtorp.h"
+#include "cxx_function.hpp"
+#include "inplace_function.h"
+
+#define DELEGATE_ARGS_SIZE 40
+#define DELEGATE_ARGS_ALIGN 8
+#include "delegate.h"
+typedef delegate::Delegate<int, int> Delegate;
+
+// Some optional stuff...
+#ifdef ADD_SSVU
+#define OPT_SSVU(...) __VA_ARGS__
+#include "FastFunc.hpp"
+#else
+#define OPT_SSVU(...)
+#endif
+#ifdef ADD_CLUGSTON
+#define OPT_CLUGSTON(...) __VA_ARGS__
+#include "FastDelegate.h"
+typedef fastdelegate::FastDelegate1<int, int> FastDelegate1;
+#else
+#define OPT_CLUGSTON(...)
+#endif
+#ifdef ADD_GNR
+#define OPT_GNR(...) __VA_ARGS__
+#include "forwarder.hpp"
+typedef gnr::forwarder<int(int), 48> gnr_forwarder;
+#else
+#define OPT_GNR(...)
+#endif
+#ifdef ADD_FOLLY
+#define OPT_FOLLY(...) __VA_ARGS__
+#include "folly/Function.h"
+#else
+#define OPT_FOLLY(...)
+#endif
+#ifdef ADD_BDE
+#define OPT_BDE(...) __VA_ARGS__
+#include "bslstl_function.h"
+#else
+#define OPT_BDE(...)
+#endif
+
+// Measurement.
+#include "registry.hpp"
+
+struct no_abstraction;
+
+typedef generic::delegate<int(int)> generic_delegate;
+typedef embxx::util::StaticFunction<int(int), 48> embxx_util_StaticFunction;
+typedef Function<int(int), 56> Function_;
+typedef stdext::inplace_function<int(int), 40> inplace_function;
+
+template<class... Sig>
+using multifunction =
+    boost::type_erasure::any<
+        boost::mpl::vector<
+            boost::type_erasure::copy_constructible<>,
+            boost::type_erasure::typeid_<>,
+            boost::type_erasure::relaxed,
+            boost::type_erasure::callable<Sig>...
+        >
+    >;
+
+int plain(int val)
+{
+    return val * 2;
+}
+
+struct func1
+{
+    int operator()(int val)
+    {
+        return val * 2;
+    }
+    
+    int a[10];
+};
+
+struct func2
+{
+    int operator()(int val)
+    {
+        return val * a;
+    }
+    
+    int& a;
+};
+
+struct A
+{
+    A(): a(2) {}
+
+    int f(int val)
+    {
+        return val * a;
+    }
+    
+    int a;
+};
+
+namespace cases
+{
+    template<class F>
+    struct base : test::base
+    {
+        typedef F function_type;
+
+        base() {}
+
+        template<class Fn>
+        explicit base(Fn&& fn)
+          : f(std::forward<Fn>(fn))
+        {}
+        
+        void benchmark()
+        {
+            this->val += f(this->val);
+        }
+        
+        F f;
+    };
+
+    template<class F>
+    struct function_pointer : base<F>
+    {
+        function_pointer()
+          : base<F>(&plain)
+        {}
+    };
+    
+    template<>
+    struct function_pointer<no_abstraction>
+      : function_pointer<int(*)(int)>
+    {};
+
+    template<class F>
+    struct compile_time_function_pointer : base<F>
+    {
+        compile_time_function_pointer()
+          : base<F>(stdex::function_wrapper<int(int), &plain>())
+        {}
+    };
+    
+    template<>
+    struct compile_time_function_pointer<generic_delegate>
+      : base<generic_delegate>
+    {
+        compile_time_function_pointer()
+          : base<generic_delegate>(generic_delegate::from<&plain>())
+        {}
+    };
+    
+    template<>
+    struct compile_time_function_pointer<no_abstraction>
+      : compile_time_function_pointer<stdex::function_wrapper<int(int), &plain> >
+    {};
+
+    template<class F>
+    struct compile_time_delegate : base<F>
+    {
+        compile_time_delegate()
+          : base<F>(stdex::method_wrapper<A, int(int), &A::f>(&a))
+        {}
+        
+        A a;
+    };
+    
+    template<>
+    struct compile_time_delegate<generic_delegate>
+      : base<generic_delegate>
+    {
+        compile_time_delegate()
+          : base<generic_delegate>(generic_delegate::from<A, &A::f>(&a))
+        {}
+        
+        A a;
+    };
+    
+    template<>
+    struct compile_time_delegate<no_abstraction>
+      : compile_time_delegate<stdex::method_wrapper<A, int(int), &A::f> >
+    {};
+            
+    template<class F>
+    struct stateless_lambda : base<F>
+    {
+        stateless_lambda()
+        {
+            this->f = [](int val)
+            {
+                return val * 2;
+            };
+        }
+    };
+    
+    template<class F>
+    struct lambda_capture : base<F>
+    {
+        lambda_capture()
+        {
+            int a = 2;
+            this->f = [a](int val)
+            {
+                return val * a;
+            };
+        }
+    };
+    
+    template<class F>
+    struct heavy_functor : base<F>
+    {
+        heavy_functor()
+          : base<F>(func1())
+        {}
+    };
+    
+    template<class F>
+    struct non_assignable : base<F>
+    {
+        non_assignable()
+          : base<F>(func2{a})
+        {}
+        
+        int a = 2;
+    };
+}
+
+BENCHMARK_WRAPPER(no_abstraction)
+BENCHMARK_WRAPPER(stdex::function<int(int)>)
+BENCHMARK_WRAPPER(stdex::basic_function<16, int(int)>)
+BENCHMARK_WRAPPER(stdex::basic_function<32, int(int)>)
+BENCHMARK_WRAPPER(stdex::basic_function<48, int(int)>)
+BENCHMARK_WRAPPER(std::function<int(int)>)
+BENCHMARK_WRAPPER(cxx_function::function<int(int)>)
+BENCHMARK_WRAPPER(multifunction<int(int)>)
+BENCHMARK_WRAPPER(boost::function<int(int)>)
+BENCHMARK_WRAPPER(func::function<int(int)>)
+BENCHMARK_WRAPPER(generic::delegate<int(int)>)
+BENCHMARK_WRAPPER(fu2::function<int(int)>)
+BENCHMARK_WRAPPER(fixed_size_function<int(int)>)
+BENCHMARK_WRAPPER(embxx_util_StaticFunction)
+BENCHMARK_WRAPPER(Function_)
+BENCHMARK_WRAPPER(inplace_function)
+BENCHMARK_WRAPPER(Delegate)
+OPT_CLUGSTON(BENCHMARK_WRAPPER(FastDelegate1))
+OPT_SSVU(BENCHMARK_WRAPPER(ssvu::FastFunc<int(int)>))
+OPT_GNR(BENCHMARK_WRAPPER(gnr_forwarder))
+OPT_FOLLY(BENCHMARK_WRAPPER(folly::Function<int(int)>))
+OPT_BDE(BENCHMARK_WRAPPER(bsl::function<int(int)>))
+
+// The wrappers of common, instantiated for the signatures other than
+// int(int) some programs run, see wrappers::for_signature.
+namespace wrappers
+{
+    template<class Sig>
+    struct delegate_for;
+
+    template<class R, class... A>
+    struct delegate_for<R(A...)>
+    {
+        typedef delegate::Delegate<R, A...> type;
+    };
+}
+
+namespace test
+{
+    template<class R, class... A>
+    struct wrapper_name<delegate::Delegate<R, A...> >
+    {
+        static char const* get() { return "Delegate"; }
+    };
+}
+
+BENCHMARK_SIGNATURE_WRAPPER("stdex::function", stdex::function<Sig>)
+BENCHMARK_SIGNATURE_WRAPPER("std::function", std::function<Sig>)
+BENCHMARK_SIGNATURE_WRAPPER("cxx_function::function", cxx_function::function<Sig>)
+BENCHMARK_SIGNATURE_WRAPPER("multifunction", multifunction<Sig>)
+BENCHMARK_SIGNATURE_WRAPPER("boost::function", boost::function<Sig>)
+BENCHMARK_SIGNATURE_WRAPPER("func::function", func::function<Sig>)
+BENCHMARK_SIGNATURE_WRAPPER("generic::delegate", generic::delegate<Sig>)
+BENCHMARK_SIGNATURE_WRAPPER("fu2::function", fu2::function<Sig>)
+BENCHMARK_SIGNATURE_WRAPPER("fixed_size_function", fixed_size_function<Sig>)
+BENCHMARK_SIGNATURE_WRAPPER("embxx_util_StaticFunction", embxx::util::StaticFunction<Sig, 48>)
+BENCHMARK_SIGNATURE_WRAPPER("Function_", Function<Sig, 56>)
+BENCHMARK_SIGNATURE_WRAPPER("inplace_function", stdext::inplace_function<Sig, 40>)
+OPT_GNR(BENCHMARK_SIGNATURE_WRAPPER("gnr_forwarder", gnr::forwarder<Sig, 48>))
+OPT_FOLLY(BENCHMARK_SIGNATURE_WRAPPER("folly::Function", folly::Function<Sig>))
+OPT_BDE(BENCHMARK_SIGNATURE_WRAPPER("bsl::function", bsl::function<Sig>))
+
+namespace wrappers
+{
+    typedef test::type_list<no_abstraction> baseline;
+
+    typedef test::type_list<
+        stdex::function<int(int)>,
+        std::function<int(int)>,
+        cxx_function::function<int(int)>,
+        multifunction<int(int)>,
+        boost::function<int(int)>,
+        func::function<int(int)>,
+        generic::delegate<int(int)>,
+        fu2::function<int(int)>,
+        fixed_size_function<int(int)>,
+        embxx_util_StaticFunction,
+        Function_,
+        inplace_function,
+        Delegate
+    > common;
+
+    // stdex::function with more than one word stored inline.
+    typedef test::type_list<
+        stdex::basic_function<16, int(int)>,
+        stdex::basic_function<32, int(int)>,
+        stdex::basic_function<48, int(int)>
+    > stdex_capacities;
+
+    // FastDelegate and FastFunc only take some of the callables.
+    typedef test::type_list<OPT_CLUGSTON(FastDelegate1)> fast_delegate;
+    typedef test::type_list<OPT_SSVU(ssvu::FastFunc<int(int)>)> fast_func;
+
+    typedef test::concat<
+        test::type_list<OPT_GNR(gnr_forwarder)>,
+        test::type_list<OPT_FOLLY(folly::Function<int(int)>)>,
+        test::type_list<OPT_BDE(bsl::function<int(int)>)>
+    >::type optional;
+
+    typedef test::concat<common, fast_delegate, fast_func, optional>::type all;
+
+    // common and optional for the signature Sig, with the same capacities.
+    template<class Sig>
+    struct for_signature
+      : test::concat<
+            test::type_list<
+                stdex::function<Sig>,
+                std::function<Sig>,
+                cxx_function::function<Sig>,
+                multifunction<Sig>,
+                boost::function<Sig>,
+                func::function<Sig>,
+                generic::delegate<Sig>,
+                fu2::function<Sig>,
+                fixed_size_function<Sig>,
+                embxx::util::StaticFunction<Sig, 48>,
+                Function<Sig, 56>,
+                stdext::inplace_function<Sig, 40>,
+                typename delegate_for<Sig>::type
+            >,
+            test::type_list<OPT_GNR(gnr::forwarder<Sig, 48>)>,
+            test::type_list<OPT_FOLLY(folly::Function<Sig>)>,
+            test::type_list<OPT_BDE(bsl::function<Sig>)>
+        >
+    {};
+}
+
+#endif